@@ -9,12 +9,36 @@
 #include <algorithm>
 #include <iomanip>
 #include <limits>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 #include <vector>
+#include <memory>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <map>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/random.h>
+#include <sys/resource.h>
+#include <sys/sysmacros.h>
+#include <sys/uio.h>
 #include <linux/fs.h>
+#include <linux/io_uring.h>
+#include <cerrno>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ERASER_X86_SIMD 1
+#endif
 
 volatile bool keep_running = true;
 
@@ -30,13 +54,663 @@ enum ExitCode {
 
 struct VerificationStats {
     unsigned long long bytes_read = 0;
+    unsigned long long hole_bytes = 0;
     unsigned long long zero_bytes = 0;
     unsigned long long non_zero_bytes = 0;
     unsigned long long first_non_zero_offset = std::numeric_limits<unsigned long long>::max();
     double duration_seconds = 0.0;
 };
 
+enum class EraseEngine {
+    Sync,
+    IoUring
+};
+
+// Podział fragmentów erase/skip między wątki --writers
+enum class WriterLayout {
+    Interleaved,
+    Contiguous
+};
+
+enum class OffloadMode {
+    None,
+    ZeroOut,
+    Discard,
+    SecureDiscard
+};
+
+// Wspólny limit zapisów w locie dla dysków podpiętych do jednego kontrolera
+struct IoBudget {
+    std::mutex mutex;
+    std::condition_variable released;
+    unsigned available;
+
+    explicit IoBudget(unsigned capacity) : available(capacity) {}
+
+    void acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait(lock, [this]() { return available > 0; });
+        --available;
+    }
+
+    bool try_acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (available == 0) {
+            return false;
+        }
+        --available;
+        return true;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++available;
+        }
+        released.notify_one();
+    }
+};
+
+// Zajęcie slotu budżetu na czas jednej operacji (bez budżetu nic nie robi)
+struct IoBudgetSlot {
+    IoBudget* budget;
+
+    explicit IoBudgetSlot(IoBudget* io_budget) : budget(io_budget) {
+        if (budget != nullptr) {
+            budget->acquire();
+        }
+    }
+
+    IoBudgetSlot(const IoBudgetSlot&) = delete;
+    IoBudgetSlot& operator=(const IoBudgetSlot&) = delete;
+
+    ~IoBudgetSlot() {
+        if (budget != nullptr) {
+            budget->release();
+        }
+    }
+};
+
+// Postęp kasowania publikowany dla innych wątków (np. zbiorczy widok trybu wsadowego)
+struct EraseProgress {
+    std::atomic<unsigned long long> processed_bytes{0};
+    std::atomic<unsigned long long> erased_bytes{0};
+    // Wszystko w cyklu erase/skip poniżej tego offsetu zostało już zapisane
+    std::atomic<unsigned long long> completed_offset{0};
+};
+
+inline unsigned long long monotonic_ns() {
+    return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Histogram opóźnień I/O: kubełki potęg dwójki dzielone na 8 części (błąd < 12.5%),
+// liczniki atomowe, więc zapis z wielu wątków nie wymaga blokad
+struct LatencyHistogram {
+    static constexpr unsigned sub_buckets = 8;
+    static constexpr unsigned bucket_count = 62 * sub_buckets;
+
+    std::atomic<unsigned long long> counts[bucket_count];
+    std::atomic<unsigned long long> total{0};
+    std::atomic<unsigned long long> max_ns{0};
+
+    LatencyHistogram() {
+        reset();
+    }
+
+    void reset() {
+        for (std::atomic<unsigned long long>& count : counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+        max_ns.store(0, std::memory_order_relaxed);
+    }
+
+    static unsigned bucket_for(unsigned long long ns) {
+        if (ns < sub_buckets) {
+            return static_cast<unsigned>(ns);
+        }
+        const unsigned top_bit = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+        return (top_bit - 2) * sub_buckets + static_cast<unsigned>((ns >> (top_bit - 3)) & (sub_buckets - 1));
+    }
+
+    static unsigned long long bucket_upper_bound(unsigned bucket) {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        const unsigned shift = bucket / sub_buckets - 1;
+        return ((sub_buckets + bucket % sub_buckets + 1ULL) << shift) - 1;
+    }
+
+    void record(unsigned long long ns) {
+        counts[bucket_for(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        unsigned long long current = max_ns.load(std::memory_order_relaxed);
+        while (ns > current && !max_ns.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Liczba operacji w kubełkach zaczynających się od threshold_ns (przybliżenie z dokładnością kubełka)
+    unsigned long long count_above(unsigned long long threshold_ns) const {
+        unsigned long long slow = 0;
+        for (unsigned bucket = bucket_for(threshold_ns); bucket < bucket_count; ++bucket) {
+            slow += counts[bucket].load(std::memory_order_relaxed);
+        }
+        return slow;
+    }
+
+    // Górna granica kubełka, w którym leży percentyl (nie więcej niż zmierzone maksimum)
+    unsigned long long percentile(double fraction) const {
+        const unsigned long long samples = total.load(std::memory_order_relaxed);
+        if (samples == 0) {
+            return 0;
+        }
+        const unsigned long long rank = std::max<unsigned long long>(1, static_cast<unsigned long long>(fraction * samples + 0.999999));
+        unsigned long long seen = 0;
+        for (unsigned bucket = 0; bucket < bucket_count; ++bucket) {
+            seen += counts[bucket].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(bucket_upper_bound(bucket), max_ns.load(std::memory_order_relaxed));
+            }
+        }
+        return max_ns.load(std::memory_order_relaxed);
+    }
+};
+
+// Offsety nieudanych operacji I/O dla telemetrii (błędy są rzadkie, więc wystarczy mutex)
+struct IoErrorLog {
+    static constexpr size_t max_entries = 64;
+
+    std::mutex mutex;
+    std::vector<std::pair<unsigned long long, int>> entries;
+    std::atomic<unsigned long long> total{0};
+
+    void record(unsigned long long offset, int error_number) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++total;
+        if (entries.size() < max_entries) {
+            entries.emplace_back(offset, error_number);
+        }
+    }
+};
+
+// Ogranicznik przepustowości i IOPS (--max-rate/--max-iops) jako token bucket w postaci "teoretycznego czasu
+// przybycia": każde żądanie rezerwuje swój odcinek czasu, więc żądania są rozłożone równo zamiast serii i pauz.
+// Limity są atomowe, więc można je zmieniać w trakcie pracy (--rate-file).
+struct RateLimiter {
+    // Dopuszczalna seria po bezczynności
+    static constexpr unsigned long long burst_ns = 20ULL * 1000 * 1000;
+    // Przy limicie przepustowości zapisy i odczyty są dzielone na żądania najwyżej tej wielkości
+    static constexpr size_t paced_request_size = 1024 * 1024;
+
+    // Oś czasu jednego limitu: rezerwacje są pozycjami w jednostkach (bajty albo operacje), a termin pozycji
+    // wynika z punktu odniesienia i bieżącego limitu, więc po zmianie limitu czekające żądania dostają nowe terminy
+    struct Timeline {
+        unsigned long long reserved = 0;
+        unsigned long long origin_units = 0;
+        unsigned long long origin_ns = 0;
+
+        unsigned long long deadline(unsigned long long position, unsigned long long rate) const {
+            return origin_ns + static_cast<unsigned long long>((position - origin_units) * 1e9 / rate);
+        }
+
+        // Pozycja osiągnięta w chwili now przy starym limicie staje się punktem odniesienia dla nowego
+        void rebase(unsigned long long now, unsigned long long old_rate) {
+            unsigned long long position = reserved;
+            if (old_rate > 0 && now < deadline(reserved, old_rate)) {
+                position = origin_units + static_cast<unsigned long long>((now - origin_ns) * (old_rate / 1e9));
+                position = std::min(std::max(position, origin_units), reserved);
+            }
+            origin_units = position;
+            origin_ns = now;
+        }
+
+        // Rezerwacja units; zwraca początek i koniec odcinka (bez kredytu za bezczynność dłuższą niż burst_ns)
+        void reserve(unsigned long long now, unsigned long long units, unsigned long long rate,
+                     unsigned long long& slot_start, unsigned long long& slot_end) {
+            if (deadline(reserved, rate) < now) {
+                origin_units = reserved;
+                origin_ns = now;
+            }
+            slot_start = reserved;
+            reserved += units;
+            slot_end = reserved;
+        }
+    };
+
+    std::atomic<unsigned long long> max_bytes_per_second{0};
+    std::atomic<unsigned long long> max_iops{0};
+    std::mutex mutex;
+    Timeline bytes_timeline;
+    Timeline ops_timeline;
+
+    bool active() const {
+        return max_bytes_per_second.load(std::memory_order_relaxed) > 0 || max_iops.load(std::memory_order_relaxed) > 0;
+    }
+
+    // Nowe limity obowiązują od razu: czekające żądania przeliczają swój termin wg nowego tempa zamiast ruszać naraz
+    void set_limits(unsigned long long bytes_per_second, unsigned long long iops) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const unsigned long long now = monotonic_ns();
+        bytes_timeline.rebase(now, max_bytes_per_second.load(std::memory_order_relaxed));
+        ops_timeline.rebase(now, max_iops.load(std::memory_order_relaxed));
+        max_bytes_per_second.store(bytes_per_second, std::memory_order_relaxed);
+        max_iops.store(iops, std::memory_order_relaxed);
+    }
+
+    size_t request_size(size_t size) const {
+        return max_bytes_per_second.load(std::memory_order_relaxed) > 0 ? std::min(size, paced_request_size) : size;
+    }
+
+    // Czeka na termin żądania o rozmiarze bytes; przerwanie (Ctrl+C) kończy oczekiwanie od razu
+    void acquire(unsigned long long bytes) {
+        unsigned long long bytes_start = 0;
+        unsigned long long bytes_end = 0;
+        unsigned long long ops_start = 0;
+        unsigned long long ops_end = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const unsigned long long rate = max_bytes_per_second.load(std::memory_order_relaxed);
+            const unsigned long long iops = max_iops.load(std::memory_order_relaxed);
+            if (rate == 0 && iops == 0) {
+                return;
+            }
+
+            const unsigned long long now = monotonic_ns();
+            if (rate > 0) {
+                bytes_timeline.reserve(now, bytes, rate, bytes_start, bytes_end);
+            }
+            if (iops > 0) {
+                ops_timeline.reserve(now, 1, iops, ops_start, ops_end);
+            }
+        }
+
+        while (keep_running) {
+            unsigned long long ready_ns = 0;
+            const unsigned long long now = monotonic_ns();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                const unsigned long long rate = max_bytes_per_second.load(std::memory_order_relaxed);
+                const unsigned long long iops = max_iops.load(std::memory_order_relaxed);
+                if (rate > 0 && bytes_end > bytes_start) {
+                    ready_ns = std::max(ready_ns, bytes_timeline.deadline(std::max(bytes_start, bytes_timeline.origin_units), rate));
+                }
+                if (iops > 0 && ops_end > ops_start) {
+                    ready_ns = std::max(ready_ns, ops_timeline.deadline(std::max(ops_start, ops_timeline.origin_units), iops));
+                }
+            }
+            if (ready_ns <= now + burst_ns) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<unsigned long long>(ready_ns - burst_ns - now, 50ULL * 1000 * 1000)));
+        }
+    }
+};
+
+// Zakres pliku zawierający dane (poza dziurami pliku rzadkiego)
+struct DataExtent {
+    unsigned long long offset = 0;
+    unsigned long long length = 0;
+};
+
+// Mapa zajętości: zakresy z bajtami !00 (zaokrąglone do ziarna) i liczba bajtów !00 w kubełkach
+struct UsageMap {
+    unsigned long long grain = 1024 * 1024;
+    unsigned long long bucket_size = 1024ULL * 1024 * 1024;
+    std::vector<DataExtent> extents;
+    std::vector<unsigned long long> bucket_non_zero;
+
+    void reset(unsigned long long target_size) {
+        extents.clear();
+        bucket_non_zero.assign(static_cast<size_t>((target_size + bucket_size - 1) / bucket_size), 0);
+    }
+
+    // Fragment nie przekracza granicy ziarna, więc trafia w jeden kubełek
+    void record(unsigned long long offset, size_t length, unsigned long long non_zero_bytes) {
+        if (non_zero_bytes == 0) {
+            return;
+        }
+
+        const unsigned long long start = offset - offset % grain;
+        const unsigned long long end = std::max(start + grain, offset + length);
+        if (!extents.empty() && extents.back().offset + extents.back().length >= start) {
+            DataExtent& last = extents.back();
+            last.length = std::max(last.length, end - last.offset);
+        } else {
+            extents.push_back({start, end - start});
+        }
+        bucket_non_zero[static_cast<size_t>(offset / bucket_size)] += non_zero_bytes;
+    }
+
+    void merge(const UsageMap& other) {
+        extents.insert(extents.end(), other.extents.begin(), other.extents.end());
+        for (size_t index = 0; index < bucket_non_zero.size() && index < other.bucket_non_zero.size(); ++index) {
+            bucket_non_zero[index] += other.bucket_non_zero[index];
+        }
+    }
+
+    // Scalanie zakresów z wielu wątków (albo map z różnych przebiegów) w posortowaną, rozłączną listę
+    void normalize(unsigned long long target_size) {
+        std::sort(extents.begin(), extents.end(), [](const DataExtent& left, const DataExtent& right) {
+            return left.offset < right.offset;
+        });
+
+        std::vector<DataExtent> merged;
+        for (const DataExtent& extent : extents) {
+            if (!merged.empty() && merged.back().offset + merged.back().length >= extent.offset) {
+                DataExtent& last = merged.back();
+                last.length = std::max(last.length, extent.offset + extent.length - last.offset);
+            } else {
+                merged.push_back(extent);
+            }
+        }
+
+        for (DataExtent& extent : merged) {
+            extent.length = std::min(extent.length, target_size - extent.offset);
+        }
+        extents.swap(merged);
+    }
+};
+
+// Rodzaj danych zapisywanych w przebiegu kasowania
+enum class PatternKind {
+    Zero,
+    Fixed,
+    Random,
+    CryptoRandom
+};
+
+// SplitMix64: słowo o numerze index wyliczane bez stanu, więc strumień można odtworzyć od dowolnego offsetu
+inline uint64_t splitmix64_word(uint64_t seed, uint64_t index) {
+    uint64_t value = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+inline uint32_t rotate_left(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+// Blok strumienia ChaCha20 (20 rund, licznik 64-bitowy) – dostęp swobodny po numerze bloku
+void chacha20_block(const uint32_t key[8], uint64_t counter, unsigned char output[64]) {
+    const uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), 0, 0
+    };
+    uint32_t state[16];
+    std::memcpy(state, input, sizeof(state));
+
+    auto quarter_round = [&state](int a, int b, int c, int d) {
+        state[a] += state[b]; state[d] = rotate_left(state[d] ^ state[a], 16);
+        state[c] += state[d]; state[b] = rotate_left(state[b] ^ state[c], 12);
+        state[a] += state[b]; state[d] = rotate_left(state[d] ^ state[a], 8);
+        state[c] += state[d]; state[b] = rotate_left(state[b] ^ state[c], 7);
+    };
+
+    for (int round = 0; round < 10; ++round) {
+        quarter_round(0, 4, 8, 12);
+        quarter_round(1, 5, 9, 13);
+        quarter_round(2, 6, 10, 14);
+        quarter_round(3, 7, 11, 15);
+        quarter_round(0, 5, 10, 15);
+        quarter_round(1, 6, 11, 12);
+        quarter_round(2, 7, 8, 13);
+        quarter_round(3, 4, 9, 14);
+    }
+
+    for (int word = 0; word < 16; ++word) {
+        const uint32_t value = state[word] + input[word];
+        output[word * 4] = static_cast<unsigned char>(value);
+        output[word * 4 + 1] = static_cast<unsigned char>(value >> 8);
+        output[word * 4 + 2] = static_cast<unsigned char>(value >> 16);
+        output[word * 4 + 3] = static_cast<unsigned char>(value >> 24);
+    }
+}
+
+// Wzorzec jednego przebiegu; zawartość zależy tylko od offsetu, więc weryfikacja odtwarza ją z ziarna
+struct PassPattern {
+    PatternKind kind = PatternKind::Zero;
+    std::vector<unsigned char> bytes;
+    uint64_t seed = 0;
+    uint32_t key[8] = {};
+
+    std::string name() const {
+        switch (kind) {
+            case PatternKind::Fixed: {
+                std::string hex = "0x";
+                const char* digits = "0123456789ABCDEF";
+                for (unsigned char value : bytes) {
+                    hex += digits[value >> 4];
+                    hex += digits[value & 0x0F];
+                }
+                return hex;
+            }
+            case PatternKind::Random:
+                return "random";
+            case PatternKind::CryptoRandom:
+                return "crypto";
+            case PatternKind::Zero:
+                break;
+        }
+        return "zero";
+    }
+
+    // Wypełnia bufor strumieniem od pozycji offset; combine = true nakłada go przez XOR (zgodne bajty dają 00)
+    void generate(unsigned char* data, unsigned long long offset, size_t length, bool combine) const {
+        switch (kind) {
+            case PatternKind::Zero:
+                if (!combine) {
+                    std::memset(data, 0, length);
+                }
+                return;
+            case PatternKind::Fixed: {
+                size_t phase = static_cast<size_t>(offset % bytes.size());
+                if (!combine) {
+                    // Jeden okres wzorca, potem podwajanie kopią (długość kopii to wielokrotność okresu)
+                    size_t filled = std::min(length, bytes.size());
+                    for (size_t index = 0; index < filled; ++index) {
+                        data[index] = bytes[(phase + index) % bytes.size()];
+                    }
+                    while (filled < length) {
+                        const size_t copy = std::min(filled, length - filled);
+                        std::memcpy(data + filled, data, copy);
+                        filled += copy;
+                    }
+                    return;
+                }
+
+                for (size_t index = 0; index < length; ++index) {
+                    data[index] ^= bytes[phase];
+                    if (++phase == bytes.size()) {
+                        phase = 0;
+                    }
+                }
+                return;
+            }
+            case PatternKind::Random: {
+                size_t position = 0;
+                while (position < length) {
+                    const unsigned long long absolute = offset + position;
+                    const uint64_t word = splitmix64_word(seed, absolute / 8);
+                    const size_t within = static_cast<size_t>(absolute % 8);
+                    const size_t count = std::min(length - position, 8 - within);
+                    if (count == 8) {
+                        uint64_t value = word;
+                        if (combine) {
+                            std::memcpy(&value, data + position, sizeof(value));
+                            value ^= word;
+                        }
+                        std::memcpy(data + position, &value, sizeof(value));
+                        position += 8;
+                        continue;
+                    }
+
+                    unsigned char word_bytes[8];
+                    std::memcpy(word_bytes, &word, sizeof(word_bytes));
+                    for (size_t index = 0; index < count; ++index) {
+                        data[position + index] = combine ? data[position + index] ^ word_bytes[within + index]
+                                                         : word_bytes[within + index];
+                    }
+                    position += count;
+                }
+                return;
+            }
+            case PatternKind::CryptoRandom: {
+                size_t position = 0;
+                unsigned char block[64];
+                while (position < length) {
+                    const unsigned long long absolute = offset + position;
+                    chacha20_block(key, absolute / 64, block);
+                    const size_t within = static_cast<size_t>(absolute % 64);
+                    const size_t count = std::min(length - position, 64 - within);
+                    for (size_t index = 0; index < count; ++index) {
+                        data[position + index] = combine ? data[position + index] ^ block[within + index]
+                                                         : block[within + index];
+                    }
+                    position += count;
+                }
+                return;
+            }
+        }
+    }
+};
+
+struct PatternFeed;
+
+struct EraseOptions {
+    EraseEngine engine = EraseEngine::Sync;
+    unsigned queue_depth = 32;
+    // --writers: liczba wątków zapisujących (1 = pętla jednowątkowa)
+    unsigned writers = 1;
+    WriterLayout layout = WriterLayout::Interleaved;
+    // Rozmiar pojedynczego zapisu niezależny od geometrii erase/skip (0 = cały fragment, io_uring: 4 MB)
+    size_t io_size = 0;
+    bool simulate = false;
+    size_t direct_alignment = 0;
+    OffloadMode offload = OffloadMode::None;
+    bool show_progress = true;
+    EraseProgress* progress = nullptr;
+    IoBudget* io_budget = nullptr;
+    unsigned long long start_offset = 0;
+    bool skip_holes = false;
+    // Jeśli ustawione, zapisywane są tylko te zakresy (dane pliku rzadkiego albo brudne zakresy z mapy)
+    const std::vector<DataExtent>* data_extents = nullptr;
+    const PassPattern* pattern = nullptr;
+    unsigned generator_threads = 1;
+    PatternFeed* feed = nullptr;
+    // --skip-clean: fragmenty są najpierw czytane i zapisywane tylko, gdy zawierają bajty !00
+    bool skip_clean = false;
+    size_t scan_chunk_size = 4 * 1024 * 1024;
+    unsigned scan_buffers = 4;
+    // Opcjonalny pomiar czasu każdego zapisu (i odczytu w --skip-clean)
+    LatencyHistogram* write_latency = nullptr;
+    LatencyHistogram* read_latency = nullptr;
+    IoErrorLog* error_log = nullptr;
+    // Wspólny limit przepustowości/IOPS zapisów i odczytów (nullptr = bez limitu)
+    RateLimiter* throttle = nullptr;
+    // --sync-window: bajty zapisane między kolejnymi sync_file_range (0 = bez okna)
+    unsigned long long sync_window = 0;
+};
+
+struct VerifyOptions {
+    size_t direct_alignment = 0;
+    unsigned threads = 1;
+    size_t chunk_size = 4 * 1024 * 1024;
+    unsigned buffer_count = 4;
+    UsageMap* usage_map = nullptr;
+    const PassPattern* expected_pattern = nullptr;
+    LatencyHistogram* read_latency = nullptr;
+    IoErrorLog* error_log = nullptr;
+    // Postęp (przeczytane bajty) publikowany dla telemetrii
+    EraseProgress* progress = nullptr;
+    RateLimiter* throttle = nullptr;
+};
+
+// Bufor wyrównany do wymagań O_DIRECT (zawsze co najmniej do strony pamięci)
+struct AlignedBuffer {
+    unsigned char* data = nullptr;
+    size_t size = 0;
+
+    AlignedBuffer(size_t buffer_size, size_t alignment) : size(buffer_size) {
+        void* memory = nullptr;
+        if (posix_memalign(&memory, std::max<size_t>(alignment, 4096), std::max<size_t>(buffer_size, 1)) != 0) {
+            throw std::bad_alloc();
+        }
+        data = static_cast<unsigned char*>(memory);
+        std::memset(data, 0, buffer_size);
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    ~AlignedBuffer() {
+        free(data);
+    }
+};
+
+// Stały obszar zer: zapis dowolnej długości idzie przez writev z wieloma iovec wskazującymi ten sam bufor,
+// więc pamięć nie zależy od erase_size (przy O_DIRECT każdy iovec jest wyrównany, bo obszar to wielokrotność sektora)
+struct ZeroSource {
+    static constexpr size_t region_size = 1024 * 1024;
+
+    AlignedBuffer region;
+    std::vector<iovec> vectors;
+
+    explicit ZeroSource(size_t alignment) : region(region_size, alignment) {}
+
+    // Ustawia iovec dla length bajtów (najwyżej IOV_MAX pozycji) i zwraca liczbę bajtów, które obejmują
+    size_t fill(std::vector<iovec>& out, size_t length) const {
+        const size_t count = std::min<size_t>((length + region_size - 1) / region_size, IOV_MAX);
+        out.resize(count);
+        size_t covered = 0;
+        for (iovec& vector : out) {
+            vector.iov_base = region.data;
+            vector.iov_len = std::min(region_size, length - covered);
+            covered += vector.iov_len;
+        }
+        return covered;
+    }
+
+    size_t prepare(size_t length) {
+        return fill(vectors, length);
+    }
+
+    const char* data() const {
+        return reinterpret_cast<const char*>(region.data);
+    }
+};
+
+struct EraseStats {
+    unsigned long long total_erased = 0;
+    unsigned long long resumed_bytes = 0;
+    unsigned long long offloaded_bytes = 0;
+    unsigned long long written_bytes = 0;
+    unsigned long long skipped_bytes = 0;
+    unsigned long long scanned_bytes = 0;
+    unsigned long long clean_bytes = 0;
+    double duration_seconds = 0.0;
+    // Końcowe fdatasync (wliczone w duration_seconds)
+    double sync_seconds = 0.0;
+};
+
+// Postęp tekstowy odświeżany najwyżej 10 razy na sekundę (zamiast po każdym fragmencie); 100% zawsze jest drukowane
+bool progress_refresh_due(double percentage) {
+    constexpr unsigned long long refresh_ns = 100ULL * 1000 * 1000;
+    static thread_local unsigned long long last_refresh_ns = 0;
+    const unsigned long long now = monotonic_ns();
+    if (percentage < 100.0 && now - last_refresh_ns < refresh_ns) {
+        return false;
+    }
+    last_refresh_ns = now;
+    return true;
+}
+
 void print_verification_progress(double percentage, double speed_mb_s) {
+    if (!progress_refresh_due(percentage)) {
+        return;
+    }
     std::cout << "\r\033[KVerification: " << std::fixed << std::setprecision(2)
               << percentage << "% | Speed: " << speed_mb_s << " MB/s";
     std::cout.flush();
@@ -59,6 +733,10 @@ void print_verification_report(unsigned long long target_size, const Verificatio
               << std::setprecision(4) << zero_percent << "%)" << std::endl;
     std::cout << "  Used (!00): " << std::setprecision(2) << non_zero_mb << " MB ("
               << stats.non_zero_bytes << " bytes, " << std::setprecision(4) << non_zero_percent << "%)" << std::endl;
+    std::cout << "  Read from media: " << std::setprecision(2) << stats.bytes_read / (1024.0 * 1024.0) << " MB ("
+              << stats.bytes_read << " bytes)" << std::endl;
+    std::cout << "  Inferred from holes: " << stats.hole_bytes / (1024.0 * 1024.0) << " MB ("
+              << stats.hole_bytes << " bytes)" << std::endl;
     std::cout << "  Verification time: " << std::setprecision(4) << stats.duration_seconds << " s" << std::endl;
     std::cout << "  Average verification speed: " << std::setprecision(2) << avg_verify_speed << " MB/s" << std::endl;
 
@@ -67,247 +745,5043 @@ void print_verification_report(unsigned long long target_size, const Verificatio
     } else {
         std::cout << "  First non-zero byte offset: not found (all bytes are 00)" << std::endl;
     }
-}
-
-bool verify_target_content(
-    int fd,
-    unsigned long long target_size,
-    bool stop_on_first_non_zero,
-    bool show_progress,
-    VerificationStats& stats,
-    std::string& error_message
-) {
-    constexpr size_t verify_chunk_size = 4 * 1024 * 1024;
-    std::vector<unsigned char> read_buffer(verify_chunk_size, 0);
-    stats = VerificationStats{};
+}
+
+// Wynik skanowania bufora: liczba bajtów różnych od 00 i indeks pierwszego z nich
+struct ZeroScanResult {
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    size_t non_zero_bytes = 0;
+    size_t first_non_zero = npos;
+};
+
+using ZeroScanFunction = ZeroScanResult (*)(const unsigned char* data, size_t length, bool stop_on_first_non_zero);
+
+struct ZeroScanner {
+    ZeroScanFunction scan;
+    const char* name;
+};
+
+// Zwraca true, gdy skanowanie ma się zakończyć (pierwszy bajt != 00 przy stop_on_first_non_zero)
+inline bool record_non_zero_mask(ZeroScanResult& result, size_t base_index, uint64_t non_zero_mask, bool stop_on_first_non_zero) {
+    if (result.first_non_zero == ZeroScanResult::npos) {
+        result.first_non_zero = base_index + static_cast<size_t>(__builtin_ctzll(non_zero_mask));
+        if (stop_on_first_non_zero) {
+            result.non_zero_bytes = 1;
+            return true;
+        }
+    }
+    result.non_zero_bytes += static_cast<size_t>(__builtin_popcountll(non_zero_mask));
+    return false;
+}
+
+void scan_zero_bytes(const unsigned char* data, size_t index, size_t length, bool stop_on_first_non_zero, ZeroScanResult& result) {
+    for (; index < length; ++index) {
+        if (data[index] != 0x00) {
+            if (record_non_zero_mask(result, index, 1, stop_on_first_non_zero)) {
+                return;
+            }
+        }
+    }
+}
+
+// Wersja przenośna: słowa 64-bitowe, bajty liczone dopiero w niezerowych słowach
+ZeroScanResult scan_zero_portable(const unsigned char* data, size_t length, bool stop_on_first_non_zero) {
+    constexpr uint64_t low_bits = 0x7F7F7F7F7F7F7F7FULL;
+    ZeroScanResult result;
+    size_t index = 0;
+
+    for (; index + 32 <= length; index += 32) {
+        uint64_t words[4];
+        std::memcpy(words, data + index, sizeof(words));
+        if ((words[0] | words[1] | words[2] | words[3]) == 0) {
+            continue;
+        }
+
+        for (size_t word_index = 0; word_index < 4; ++word_index) {
+            const uint64_t word = words[word_index];
+            if (word == 0) {
+                continue;
+            }
+
+            if (result.first_non_zero == ZeroScanResult::npos || stop_on_first_non_zero) {
+                scan_zero_bytes(data, index + word_index * 8, index + word_index * 8 + 8, stop_on_first_non_zero, result);
+                if (stop_on_first_non_zero) {
+                    return result;
+                }
+                continue;
+            }
+
+            // Najstarszy bit każdego bajtu ustawiony, gdy bajt jest różny od 00
+            const uint64_t non_zero_flags = ((word & low_bits) + low_bits) | word;
+            result.non_zero_bytes += static_cast<size_t>(__builtin_popcountll(non_zero_flags & ~low_bits));
+        }
+    }
+
+    scan_zero_bytes(data, index, length, stop_on_first_non_zero, result);
+    return result;
+}
+
+#ifdef ERASER_X86_SIMD
+ZeroScanResult scan_zero_sse2(const unsigned char* data, size_t length, bool stop_on_first_non_zero) {
+    ZeroScanResult result;
+    const __m128i zero = _mm_setzero_si128();
+    size_t index = 0;
+
+    for (; index + 64 <= length; index += 64) {
+        const __m128i vectors[4] = {
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + 16)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + 32)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + 48))
+        };
+        const __m128i combined = _mm_or_si128(_mm_or_si128(vectors[0], vectors[1]), _mm_or_si128(vectors[2], vectors[3]));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(combined, zero)) == 0xFFFF) {
+            continue;
+        }
+
+        for (size_t vector_index = 0; vector_index < 4; ++vector_index) {
+            const uint64_t mask = ~static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(vectors[vector_index], zero))) & 0xFFFFULL;
+            if (mask != 0 && record_non_zero_mask(result, index + vector_index * 16, mask, stop_on_first_non_zero)) {
+                return result;
+            }
+        }
+    }
+
+    scan_zero_bytes(data, index, length, stop_on_first_non_zero, result);
+    return result;
+}
+
+__attribute__((target("avx2,popcnt,bmi")))
+ZeroScanResult scan_zero_avx2(const unsigned char* data, size_t length, bool stop_on_first_non_zero) {
+    ZeroScanResult result;
+    const __m256i zero = _mm256_setzero_si256();
+    size_t index = 0;
+
+    for (; index + 128 <= length; index += 128) {
+        const __m256i vectors[4] = {
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index + 32)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index + 64)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index + 96))
+        };
+        const __m256i combined = _mm256_or_si256(_mm256_or_si256(vectors[0], vectors[1]), _mm256_or_si256(vectors[2], vectors[3]));
+        if (_mm256_testz_si256(combined, combined)) {
+            continue;
+        }
+
+        for (size_t vector_index = 0; vector_index < 4; ++vector_index) {
+            const uint32_t zero_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(vectors[vector_index], zero)));
+            const uint64_t mask = static_cast<uint64_t>(~zero_mask);
+            if (mask != 0 && record_non_zero_mask(result, index + vector_index * 32, mask, stop_on_first_non_zero)) {
+                return result;
+            }
+        }
+    }
+
+    scan_zero_bytes(data, index, length, stop_on_first_non_zero, result);
+    return result;
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt,bmi")))
+ZeroScanResult scan_zero_avx512(const unsigned char* data, size_t length, bool stop_on_first_non_zero) {
+    ZeroScanResult result;
+    size_t index = 0;
+
+    for (; index + 256 <= length; index += 256) {
+        const __m512i vectors[4] = {
+            _mm512_loadu_si512(data + index),
+            _mm512_loadu_si512(data + index + 64),
+            _mm512_loadu_si512(data + index + 128),
+            _mm512_loadu_si512(data + index + 192)
+        };
+        const __m512i combined = _mm512_or_si512(_mm512_or_si512(vectors[0], vectors[1]), _mm512_or_si512(vectors[2], vectors[3]));
+        if (_mm512_test_epi64_mask(combined, combined) == 0) {
+            continue;
+        }
+
+        for (size_t vector_index = 0; vector_index < 4; ++vector_index) {
+            const uint64_t mask = _mm512_test_epi8_mask(vectors[vector_index], vectors[vector_index]);
+            if (mask != 0 && record_non_zero_mask(result, index + vector_index * 64, mask, stop_on_first_non_zero)) {
+                return result;
+            }
+        }
+    }
+
+    scan_zero_bytes(data, index, length, stop_on_first_non_zero, result);
+    return result;
+}
+#endif
+
+// Wybór najszybszej implementacji przy pierwszym użyciu (detekcja CPU w czasie działania)
+const ZeroScanner& active_zero_scanner() {
+    static const ZeroScanner scanner = []() {
+#ifdef ERASER_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+            return ZeroScanner{scan_zero_avx512, "avx512bw"};
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return ZeroScanner{scan_zero_avx2, "avx2"};
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return ZeroScanner{scan_zero_sse2, "sse2"};
+        }
+#endif
+        return ZeroScanner{scan_zero_portable, "portable"};
+    }();
+    return scanner;
+}
+
+// Odczyt fragmentu przez pread; przy O_DIRECT długość zaokrąglana do pełnych bloków i obcinana do length
+ssize_t read_verify_chunk(int fd, unsigned char* buffer, unsigned long long offset, size_t length, size_t direct_alignment) {
+    size_t request_length = length;
+    if (direct_alignment > 0 && request_length % direct_alignment != 0) {
+        request_length += direct_alignment - request_length % direct_alignment;
+    }
+
+    size_t total_read = 0;
+    while (total_read < request_length) {
+        const ssize_t read_result = pread(fd, buffer + total_read, request_length - total_read,
+                                          static_cast<off_t>(offset + total_read));
+        if (read_result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        if (read_result == 0) {
+            break;
+        }
+
+        total_read += static_cast<size_t>(read_result);
+        if (direct_alignment > 0 && total_read % direct_alignment != 0) {
+            break;
+        }
+    }
+
+    return static_cast<ssize_t>(std::min(total_read, length));
+}
+
+// Odczyt fragmentu z limitem (--max-rate/--max-iops): jak przy zapisie dzielony na żądania request_size(),
+// każde rezerwuje swój termin osobno; opóźnienie mierzy sam odczyt, bez oczekiwania na termin
+ssize_t read_paced_chunk(int fd, unsigned char* buffer, unsigned long long offset, size_t length, size_t direct_alignment,
+                         RateLimiter* throttle, LatencyHistogram* latency) {
+    size_t total_read = 0;
+    while (total_read < length) {
+        size_t request_length = length - total_read;
+        if (throttle != nullptr) {
+            request_length = throttle->request_size(request_length);
+            throttle->acquire(request_length);
+        }
+        const unsigned long long read_start = latency != nullptr ? monotonic_ns() : 0;
+        const ssize_t read_result = read_verify_chunk(fd, buffer + total_read, offset + total_read, request_length, direct_alignment);
+        const int read_error = errno;
+        if (latency != nullptr) {
+            latency->record(monotonic_ns() - read_start);
+        }
+        if (read_result < 0) {
+            errno = read_error;
+            return -1;
+        }
+
+        total_read += static_cast<size_t>(read_result);
+        if (static_cast<size_t>(read_result) < request_length) {
+            break;
+        }
+    }
+    return static_cast<ssize_t>(total_read);
+}
+
+// Potok odczytu z wyprzedzeniem: wątek czytający wypełnia pierścień buforów,
+// a konsument skanuje je po kolei, więc nośnik i CPU pracują jednocześnie
+struct ReadAheadPipeline {
+    struct Chunk {
+        unsigned long long offset = 0;
+        size_t length = 0;
+        ssize_t read_result = 0;
+        int error = 0;
+        unsigned char* data = nullptr;
+    };
+
+    using RangeSource = std::function<bool(unsigned long long& offset, size_t& length)>;
+
+    int fd;
+    size_t direct_alignment;
+    RangeSource next_range;
+    LatencyHistogram* latency;
+    RateLimiter* throttle;
+    std::vector<std::unique_ptr<AlignedBuffer>> buffers;
+    std::vector<Chunk> slots;
+    unsigned long long produced = 0;
+    unsigned long long consumed = 0;
+    bool reader_done = false;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread reader;
+
+    ReadAheadPipeline(int target_fd, size_t chunk_size, unsigned buffer_count, size_t alignment, RangeSource source,
+                      LatencyHistogram* read_latency = nullptr, RateLimiter* read_throttle = nullptr)
+        : fd(target_fd), direct_alignment(alignment), next_range(std::move(source)), latency(read_latency), throttle(read_throttle),
+          slots(buffer_count) {
+        for (unsigned index = 0; index < buffer_count; ++index) {
+            buffers.emplace_back(new AlignedBuffer(chunk_size, alignment));
+        }
+        reader = std::thread(&ReadAheadPipeline::run_reader, this);
+    }
+
+    ReadAheadPipeline(const ReadAheadPipeline&) = delete;
+    ReadAheadPipeline& operator=(const ReadAheadPipeline&) = delete;
+
+    ~ReadAheadPipeline() {
+        stop();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        if (reader.joinable()) {
+            reader.join();
+        }
+    }
+
+    // Czeka na kolejny wypełniony bufor; false, gdy zakresy się skończyły
+    bool next(Chunk& chunk) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return consumed < produced || reader_done; });
+        if (consumed == produced) {
+            return false;
+        }
+        chunk = slots[consumed % slots.size()];
+        return true;
+    }
+
+    // Oddaje bufor ostatnio pobranego fragmentu do ponownego odczytu
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++consumed;
+        }
+        changed.notify_all();
+    }
+
+    void run_reader() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this]() { return stopping || produced - consumed < slots.size(); });
+                if (stopping) {
+                    break;
+                }
+            }
+
+            Chunk chunk;
+            if (!next_range(chunk.offset, chunk.length)) {
+                break;
+            }
+
+            const size_t slot = static_cast<size_t>(produced % slots.size());
+            chunk.data = buffers[slot]->data;
+            chunk.read_result = read_paced_chunk(fd, chunk.data, chunk.offset, chunk.length, direct_alignment, throttle, latency);
+            chunk.error = chunk.read_result < 0 ? errno : 0;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slots[slot] = chunk;
+                ++produced;
+            }
+            changed.notify_all();
+
+            if (chunk.read_result <= 0) {
+                break;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            reader_done = true;
+        }
+        changed.notify_all();
+    }
+};
+
+void merge_verification_stats(VerificationStats& total, const VerificationStats& part) {
+    total.bytes_read += part.bytes_read;
+    total.non_zero_bytes += part.non_zero_bytes;
+    total.first_non_zero_offset = std::min(total.first_non_zero_offset, part.first_non_zero_offset);
+}
+
+// Zakresy z danymi wg SEEK_DATA/SEEK_HOLE; false, gdy cel nie jest zwykłym plikiem albo FS tego nie wspiera
+bool map_data_extents(int fd, unsigned long long target_size, std::vector<DataExtent>& extents) {
+    struct stat target_stat {};
+    if (fstat(fd, &target_stat) != 0 || !S_ISREG(target_stat.st_mode)) {
+        return false;
+    }
+
+    extents.clear();
+    unsigned long long position = 0;
+    while (position < target_size) {
+        const off_t data_start = lseek(fd, static_cast<off_t>(position), SEEK_DATA);
+        if (data_start < 0) {
+            if (errno == ENXIO) {
+                break;
+            }
+            extents.clear();
+            return false;
+        }
+
+        if (static_cast<unsigned long long>(data_start) >= target_size) {
+            break;
+        }
+
+        off_t hole_start = lseek(fd, data_start, SEEK_HOLE);
+        if (hole_start < 0 || static_cast<unsigned long long>(hole_start) > target_size) {
+            hole_start = static_cast<off_t>(target_size);
+        }
+
+        extents.push_back({static_cast<unsigned long long>(data_start),
+                           static_cast<unsigned long long>(hole_start - data_start)});
+        position = static_cast<unsigned long long>(hole_start);
+    }
+    return true;
+}
+
+// Dzieli [offset, end) na dziurę na początku i następujący po niej kawałek danych
+void split_at_holes(const std::vector<DataExtent>& extents, unsigned long long offset, unsigned long long end,
+                    unsigned long long& hole_length, unsigned long long& data_length) {
+    auto extent = std::upper_bound(extents.begin(), extents.end(), offset, [](unsigned long long value, const DataExtent& candidate) {
+        return value < candidate.offset + candidate.length;
+    });
+
+    if (extent == extents.end() || extent->offset >= end) {
+        hole_length = end - offset;
+        data_length = 0;
+        return;
+    }
+
+    const unsigned long long data_start = std::max(offset, extent->offset);
+    hole_length = data_start - offset;
+    data_length = std::min(end, extent->offset + extent->length) - data_start;
+}
+
+// Plan odczytu: zakresy z danymi pocięte na fragmenty po chunk_size; dziury nie są czytane
+struct VerifyPlan {
+    std::vector<DataExtent> extents;
+    std::vector<unsigned long long> first_chunk;
+    unsigned long long chunk_count = 0;
+    unsigned long long data_bytes = 0;
+    size_t chunk_size = 0;
+
+    VerifyPlan(std::vector<DataExtent> data_extents, size_t plan_chunk_size)
+        : extents(std::move(data_extents)), chunk_size(plan_chunk_size) {
+        for (const DataExtent& extent : extents) {
+            first_chunk.push_back(chunk_count);
+            chunk_count += (extent.length + chunk_size - 1) / chunk_size;
+            data_bytes += extent.length;
+        }
+    }
+
+    void chunk_at(unsigned long long index, unsigned long long& offset, size_t& length) const {
+        const size_t extent_index = static_cast<size_t>(
+            std::upper_bound(first_chunk.begin(), first_chunk.end(), index) - first_chunk.begin() - 1);
+        const DataExtent& extent = extents[extent_index];
+        offset = extent.offset + (index - first_chunk[extent_index]) * chunk_size;
+        length = static_cast<size_t>(std::min<unsigned long long>(chunk_size, extent.offset + extent.length - offset));
+    }
+
+    unsigned long long data_bytes_below(unsigned long long position) const {
+        unsigned long long total = 0;
+        for (const DataExtent& extent : extents) {
+            if (extent.offset >= position) {
+                break;
+            }
+            total += std::min(extent.length, position - extent.offset);
+        }
+        return total;
+    }
+};
+
+VerifyPlan make_verify_plan(int fd, unsigned long long target_size, size_t chunk_size, bool skip_holes = true) {
+    std::vector<DataExtent> extents;
+    if (!skip_holes || !map_data_extents(fd, target_size, extents)) {
+        extents.assign(1, DataExtent{0, target_size});
+    }
+    return VerifyPlan(std::move(extents), chunk_size);
+}
+
+// Skan fragmentu; z mapą zajętości fragment jest dzielony na ziarna, by zapamiętać położenie bajtów !00.
+// Przy oczekiwanym wzorcu dane są najpierw składane z nim przez XOR, więc bajty !00 to niezgodności.
+ZeroScanResult scan_verify_chunk(
+    const ZeroScanner& scanner,
+    unsigned char* data,
+    unsigned long long offset,
+    size_t length,
+    bool stop_on_first_non_zero,
+    UsageMap* usage_map,
+    const PassPattern* expected_pattern
+) {
+    if (expected_pattern != nullptr) {
+        expected_pattern->generate(data, offset, length, true);
+    }
+
+    if (usage_map == nullptr) {
+        return scanner.scan(data, length, stop_on_first_non_zero);
+    }
+
+    ZeroScanResult total;
+    size_t position = 0;
+    while (position < length) {
+        const unsigned long long absolute = offset + position;
+        const size_t piece = static_cast<size_t>(std::min<unsigned long long>(length - position, usage_map->grain - absolute % usage_map->grain));
+        const ZeroScanResult part = scanner.scan(data + position, piece, stop_on_first_non_zero);
+        if (part.first_non_zero != ZeroScanResult::npos) {
+            if (total.first_non_zero == ZeroScanResult::npos) {
+                total.first_non_zero = position + part.first_non_zero;
+            }
+            if (stop_on_first_non_zero) {
+                total.non_zero_bytes = part.non_zero_bytes;
+                return total;
+            }
+        }
+        total.non_zero_bytes += part.non_zero_bytes;
+        usage_map->record(absolute, piece, part.non_zero_bytes);
+        position += piece;
+    }
+    return total;
+}
+
+// Weryfikacja wielowątkowa: wątki pobierają kolejne fragmenty (shardy) z licznika i czytają je przez pread
+bool verify_target_content_parallel(
+    int fd,
+    unsigned long long target_size,
+    const VerifyPlan& plan,
+    const VerifyOptions& options,
+    bool stop_on_first_non_zero,
+    bool show_progress,
+    VerificationStats& stats,
+    std::string& error_message
+) {
+    constexpr unsigned long long not_found = std::numeric_limits<unsigned long long>::max();
+    const ZeroScanner& scanner = active_zero_scanner();
+
+    std::vector<std::unique_ptr<AlignedBuffer>> buffers;
+    for (unsigned worker_index = 0; worker_index < options.threads; ++worker_index) {
+        buffers.emplace_back(new AlignedBuffer(options.chunk_size, options.direct_alignment));
+    }
+
+    std::vector<VerificationStats> shard_stats(options.threads);
+    std::vector<UsageMap> shard_maps;
+    if (options.usage_map != nullptr) {
+        shard_maps.assign(options.threads, *options.usage_map);
+    }
+    std::atomic<unsigned long long> next_chunk{0};
+    std::atomic<unsigned long long> first_found{not_found};
+    std::atomic<unsigned long long> scanned_bytes{0};
+    std::atomic<unsigned> finished_workers{0};
+    std::atomic<bool> failed{false};
+    stats = VerificationStats{};
+
+    auto worker = [&](unsigned worker_index) {
+        VerificationStats& local = shard_stats[worker_index];
+        UsageMap* local_map = shard_maps.empty() ? nullptr : &shard_maps[worker_index];
+        unsigned char* buffer = buffers[worker_index]->data;
+
+        while (keep_running && !failed.load(std::memory_order_relaxed)) {
+            const unsigned long long chunk_index = next_chunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk_index >= plan.chunk_count) {
+                break;
+            }
+
+            // Fragmenty są wydawane rosnąco, więc za znalezionym bajtem nie ma już czego szukać
+            unsigned long long offset = 0;
+            size_t length = 0;
+            plan.chunk_at(chunk_index, offset, length);
+            if (stop_on_first_non_zero && offset >= first_found.load(std::memory_order_acquire)) {
+                break;
+            }
+
+            const ssize_t read_result = read_paced_chunk(fd, buffer, offset, length, options.direct_alignment,
+                                                         options.throttle, options.read_latency);
+            if (read_result < 0) {
+                if (options.error_log != nullptr) {
+                    options.error_log->record(offset, errno);
+                }
+                failed = true;
+                break;
+            }
+
+            if (read_result == 0) {
+                break;
+            }
+
+            const ZeroScanResult scan = scan_verify_chunk(scanner, buffer, offset, static_cast<size_t>(read_result),
+                                                          stop_on_first_non_zero, local_map, options.expected_pattern);
+            if (scan.first_non_zero != ZeroScanResult::npos) {
+                const unsigned long long found_offset = offset + scan.first_non_zero;
+                local.first_non_zero_offset = std::min(local.first_non_zero_offset, found_offset);
+
+                if (stop_on_first_non_zero) {
+                    unsigned long long current = first_found.load(std::memory_order_relaxed);
+                    while (found_offset < current
+                           && !first_found.compare_exchange_weak(current, found_offset, std::memory_order_acq_rel)) {
+                    }
+                    local.non_zero_bytes += 1;
+                    local.bytes_read += scan.first_non_zero + 1;
+                    scanned_bytes.fetch_add(scan.first_non_zero + 1, std::memory_order_relaxed);
+                    continue;
+                }
+            }
+
+            local.non_zero_bytes += scan.non_zero_bytes;
+            local.bytes_read += static_cast<unsigned long long>(read_result);
+            scanned_bytes.fetch_add(static_cast<unsigned long long>(read_result), std::memory_order_relaxed);
+        }
+
+        finished_workers.fetch_add(1, std::memory_order_release);
+    };
+
+    auto verify_start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned worker_index = 0; worker_index < options.threads; ++worker_index) {
+        workers.emplace_back(worker, worker_index);
+    }
+
+    while (finished_workers.load(std::memory_order_acquire) < options.threads) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const unsigned long long bytes_done = scanned_bytes.load(std::memory_order_relaxed);
+        const double percentage = plan.data_bytes > 0 ? (bytes_done * 100.0) / plan.data_bytes : 100.0;
+        if (options.progress != nullptr) {
+            // Dziury są pomijane, więc postęp względem całego celu jest skalowany
+            options.progress->processed_bytes.store(static_cast<unsigned long long>(target_size * (percentage / 100.0)),
+                                                    std::memory_order_relaxed);
+        }
+        if (show_progress) {
+            auto now = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = now - verify_start;
+            const double speed_mb_s = elapsed.count() > 0.0
+                ? (bytes_done / (1024.0 * 1024.0)) / elapsed.count()
+                : 0.0;
+            print_verification_progress(percentage, speed_mb_s);
+        }
+    }
+
+    for (std::thread& worker_thread : workers) {
+        worker_thread.join();
+    }
+
+    if (failed) {
+        error_message = "Read error while verifying target content.";
+        return false;
+    }
+
+    for (const VerificationStats& part : shard_stats) {
+        merge_verification_stats(stats, part);
+    }
+    for (const UsageMap& part : shard_maps) {
+        options.usage_map->merge(part);
+    }
+
+    // Wszystko przed pierwszym znalezionym bajtem zostało przeczytane (albo jest dziurą) i jest zerem,
+    // więc wynik jest taki sam jak przy skanowaniu sekwencyjnym
+    if (stop_on_first_non_zero && stats.first_non_zero_offset != not_found && keep_running) {
+        const unsigned long long scanned_end = stats.first_non_zero_offset + 1;
+        stats.bytes_read = plan.data_bytes_below(scanned_end);
+        stats.hole_bytes = scanned_end - stats.bytes_read;
+        stats.non_zero_bytes = 1;
+    } else if (keep_running) {
+        stats.hole_bytes = target_size - plan.data_bytes;
+    }
+    stats.zero_bytes = stats.bytes_read + stats.hole_bytes - stats.non_zero_bytes;
+
+    auto verify_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> verify_duration = verify_end - verify_start;
+    stats.duration_seconds = verify_duration.count();
+    return true;
+}
+
+bool verify_target_content(
+    int fd,
+    unsigned long long target_size,
+    const VerifyOptions& options,
+    bool stop_on_first_non_zero,
+    bool show_progress,
+    VerificationStats& stats,
+    std::string& error_message
+) {
+    // Dla plików rzadkich czytane są tylko zakresy z danymi, dziury liczone są jako 00;
+    // przy oczekiwanym wzorcu dziura jest niezgodnością, więc czytany jest cały cel
+    const VerifyPlan plan = make_verify_plan(fd, target_size, options.chunk_size, options.expected_pattern == nullptr);
+    if (options.usage_map != nullptr) {
+        options.usage_map->reset(target_size);
+    }
+
+    if (options.threads > 1) {
+        const bool verified = verify_target_content_parallel(fd, target_size, plan, options, stop_on_first_non_zero, show_progress, stats, error_message);
+        if (verified && options.usage_map != nullptr) {
+            options.usage_map->normalize(target_size);
+        }
+        return verified;
+    }
+
+    const ZeroScanner& scanner = active_zero_scanner();
+    stats = VerificationStats{};
+
+    if (options.direct_alignment == 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    auto verify_start = std::chrono::high_resolution_clock::now();
+    unsigned long long next_chunk = 0;
+    ReadAheadPipeline pipeline(fd, options.chunk_size, options.buffer_count, options.direct_alignment,
+        [&](unsigned long long& range_offset, size_t& range_length) {
+            if (next_chunk >= plan.chunk_count || !keep_running) {
+                return false;
+            }
+            plan.chunk_at(next_chunk++, range_offset, range_length);
+            return true;
+        }, options.read_latency, options.throttle);
+
+    unsigned long long scanned_end = 0;
+    ReadAheadPipeline::Chunk chunk;
+    while (keep_running && pipeline.next(chunk)) {
+        const unsigned long long offset = chunk.offset;
+        const ssize_t read_result = chunk.read_result;
+
+        if (read_result < 0) {
+            if (options.error_log != nullptr) {
+                options.error_log->record(offset, chunk.error != 0 ? chunk.error : EIO);
+            }
+            error_message = "Read error while verifying target content.";
+            return false;
+        }
+
+        if (read_result == 0) {
+            break;
+        }
+
+        // Luka między poprzednim a bieżącym fragmentem to dziura pliku rzadkiego
+        stats.hole_bytes += offset - scanned_end;
+        scanned_end = offset + static_cast<unsigned long long>(read_result);
+
+        const ZeroScanResult scan = scan_verify_chunk(scanner, chunk.data, offset, static_cast<size_t>(read_result),
+                                                      stop_on_first_non_zero, options.usage_map, options.expected_pattern);
+        if (scan.first_non_zero != ZeroScanResult::npos) {
+            if (stats.first_non_zero_offset == std::numeric_limits<unsigned long long>::max()) {
+                stats.first_non_zero_offset = offset + static_cast<unsigned long long>(scan.first_non_zero);
+            }
+
+            if (stop_on_first_non_zero) {
+                stats.non_zero_bytes += 1;
+                stats.bytes_read += static_cast<unsigned long long>(scan.first_non_zero + 1);
+                stats.zero_bytes = stats.bytes_read + stats.hole_bytes - stats.non_zero_bytes;
+                auto verify_end = std::chrono::high_resolution_clock::now();
+                std::chrono::duration<double> verify_duration = verify_end - verify_start;
+                stats.duration_seconds = verify_duration.count();
+                return true;
+            }
+        }
+        const unsigned long long chunk_non_zero = scan.non_zero_bytes;
+
+        stats.bytes_read += static_cast<unsigned long long>(read_result);
+        stats.non_zero_bytes += chunk_non_zero;
+        stats.zero_bytes = stats.bytes_read + stats.hole_bytes - stats.non_zero_bytes;
+        pipeline.release();
+        if (options.progress != nullptr) {
+            options.progress->processed_bytes.store(stats.bytes_read + stats.hole_bytes, std::memory_order_relaxed);
+        }
+
+        if (show_progress) {
+            auto now = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> elapsed = now - verify_start;
+            const double percentage = target_size > 0 ? ((stats.bytes_read + stats.hole_bytes) * 100.0) / target_size : 0.0;
+            const double speed_mb_s = elapsed.count() > 0.0
+                ? (stats.bytes_read / (1024.0 * 1024.0)) / elapsed.count()
+                : 0.0;
+            print_verification_progress(percentage, speed_mb_s);
+        }
+    }
+
+    if (keep_running && scanned_end < target_size) {
+        stats.hole_bytes += target_size - scanned_end;
+        stats.zero_bytes = stats.bytes_read + stats.hole_bytes - stats.non_zero_bytes;
+    }
+    if (options.usage_map != nullptr) {
+        options.usage_map->normalize(target_size);
+    }
+
+    auto verify_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> verify_duration = verify_end - verify_start;
+    stats.duration_seconds = verify_duration.count();
+    return true;
+}
+
+bool ask_user_to_continue() {
+    std::string answer;
+    std::cout << "Detected non-zero bytes on target. Start erasing data? [y/N]: ";
+    std::getline(std::cin, answer);
+
+    if (!std::cin.good()) {
+        return false;
+    }
+
+    std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char character) {
+        return static_cast<char>(std::tolower(character));
+    });
+
+    return answer == "y" || answer == "yes";
+}
+
+bool parse_size_mb(const char* raw_value, const char* field_name, bool allow_zero, size_t& out_bytes, std::string& error) {
+    const std::string value = raw_value != nullptr ? raw_value : "";
+    if (value.empty()) {
+        error = std::string("Field '") + field_name + "' is empty.";
+        return false;
+    }
+
+    if (value[0] == '-') {
+        error = std::string("Field '") + field_name + "' cannot be negative.";
+        return false;
+    }
+
+    size_t parsed_chars = 0;
+    unsigned long long mb_value = 0;
+
+    try {
+        mb_value = std::stoull(value, &parsed_chars, 10);
+    } catch (const std::invalid_argument&) {
+        error = std::string("Field '") + field_name + "' must be an integer number in MB (example: 8).";
+        return false;
+    } catch (const std::out_of_range&) {
+        error = std::string("Field '") + field_name + "' is too large.";
+        return false;
+    }
+
+    if (parsed_chars != value.size()) {
+        error = std::string("Field '") + field_name + "' contains invalid characters: '" + value + "'.";
+        return false;
+    }
+
+    if (!allow_zero && mb_value == 0) {
+        error = std::string("Field '") + field_name + "' must be greater than 0 MB.";
+        return false;
+    }
+
+    const unsigned long long bytes_per_mb = 1024ULL * 1024ULL;
+    if (mb_value > (std::numeric_limits<size_t>::max() / bytes_per_mb)) {
+        error = std::string("Field '") + field_name + "' is too large for this system.";
+        return false;
+    }
+
+    out_bytes = static_cast<size_t>(mb_value * bytes_per_mb);
+    return true;
+}
+
+bool parse_count(const std::string& value, const char* field_name, unsigned long long min_value,
+                 unsigned long long max_value, unsigned long long& out_value, std::string& error) {
+    if (value.empty()) {
+        error = std::string("Field '") + field_name + "' is empty.";
+        return false;
+    }
+
+    if (value[0] == '-') {
+        error = std::string("Field '") + field_name + "' cannot be negative.";
+        return false;
+    }
+
+    size_t parsed_chars = 0;
+    unsigned long long parsed_value = 0;
+
+    try {
+        parsed_value = std::stoull(value, &parsed_chars, 10);
+    } catch (const std::invalid_argument&) {
+        error = std::string("Field '") + field_name + "' must be an integer number.";
+        return false;
+    } catch (const std::out_of_range&) {
+        error = std::string("Field '") + field_name + "' is too large.";
+        return false;
+    }
+
+    if (parsed_chars != value.size()) {
+        error = std::string("Field '") + field_name + "' contains invalid characters: '" + value + "'.";
+        return false;
+    }
+
+    if (parsed_value < min_value || parsed_value > max_value) {
+        error = std::string("Field '") + field_name + "' must be between " + std::to_string(min_value)
+            + " and " + std::to_string(max_value) + ".";
+        return false;
+    }
+
+    out_value = parsed_value;
+    return true;
+}
+
+// Lista liczb rozdzielonych przecinkami, np. "1,4,16"; każda w zakresie jak w parse_count
+bool parse_count_list(const std::string& value, const char* field_name, unsigned long long min_value,
+                      unsigned long long max_value, std::vector<unsigned long long>& out_values, std::string& error) {
+    out_values.clear();
+    std::stringstream list(value);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        unsigned long long parsed_value = 0;
+        if (!parse_count(item, field_name, min_value, max_value, parsed_value, error)) {
+            return false;
+        }
+        out_values.push_back(parsed_value);
+    }
+
+    if (out_values.empty()) {
+        error = std::string("Field '") + field_name + "' is empty.";
+        return false;
+    }
+    return true;
+}
+
+// Limity z pliku --rate-file: "max-rate=MB max-iops=N" (spacje lub nowe linie, 0 = bez limitu, brak klucza = bez zmian)
+bool parse_rate_limits(const std::string& text, unsigned long long& bytes_per_second, unsigned long long& iops, std::string& error) {
+    std::stringstream tokens(text);
+    std::string token;
+    while (tokens >> token) {
+        const size_t separator = token.find('=');
+        const std::string key = token.substr(0, separator);
+        const std::string value = separator == std::string::npos ? std::string() : token.substr(separator + 1);
+        if (key == "max-rate") {
+            size_t rate = 0;
+            if (!parse_size_mb(value.c_str(), "max-rate", true, rate, error)) {
+                return false;
+            }
+            bytes_per_second = rate;
+        } else if (key == "max-iops") {
+            if (!parse_count(value, "max-iops", 0, 10000000, iops, error)) {
+                return false;
+            }
+        } else {
+            error = "Unknown rate limit '" + key + "' (expected max-rate=MB or max-iops=N).";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Klasa priorytetu I/O dla ioprio_set: idle, be[:0-7] albo rt[:0-7] (domyślny poziom 4)
+bool parse_io_priority(const std::string& value, int& io_priority, std::string& error) {
+    constexpr int class_shift = 13;
+    const size_t separator = value.find(':');
+    const std::string name = value.substr(0, separator);
+    int io_class = 0;
+    if (name == "rt" || name == "realtime") {
+        io_class = 1;
+    } else if (name == "be" || name == "best-effort") {
+        io_class = 2;
+    } else if (name == "idle") {
+        io_class = 3;
+    } else {
+        error = "Unknown I/O priority class: '" + name + "' (expected idle, be or rt).";
+        return false;
+    }
+
+    unsigned long long level = 4;
+    if (separator != std::string::npos) {
+        if (io_class == 3) {
+            error = "I/O priority class idle does not take a level.";
+            return false;
+        }
+        if (!parse_count(value.substr(separator + 1), "--ioprio level", 0, 7, level, error)) {
+            return false;
+        }
+    }
+    io_priority = (io_class << class_shift) | (io_class == 3 ? 0 : static_cast<int>(level));
+    return true;
+}
+
+// Lista przebiegów "random,0x55AA,zero": zero, one (0xFF), random (SplitMix64), crypto (ChaCha20) albo bajty w hex
+bool parse_pattern_list(const std::string& value, std::vector<PassPattern>& passes, std::string& error) {
+    std::stringstream list(value);
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        PassPattern pass;
+        if (name == "zero" || name == "0x00") {
+            pass.kind = PatternKind::Zero;
+        } else if (name == "one") {
+            pass.kind = PatternKind::Fixed;
+            pass.bytes.assign(1, 0xFF);
+        } else if (name == "random") {
+            pass.kind = PatternKind::Random;
+        } else if (name == "crypto") {
+            pass.kind = PatternKind::CryptoRandom;
+        } else if (name.size() > 2 && name.size() % 2 == 0 && name.size() <= 130 && name.compare(0, 2, "0x") == 0
+                   && name.find_first_not_of("0123456789abcdefABCDEF", 2) == std::string::npos) {
+            pass.kind = PatternKind::Fixed;
+            for (size_t index = 2; index < name.size(); index += 2) {
+                pass.bytes.push_back(static_cast<unsigned char>(std::stoul(name.substr(index, 2), nullptr, 16)));
+            }
+            if (std::all_of(pass.bytes.begin(), pass.bytes.end(), [](unsigned char byte) { return byte == 0; })) {
+                pass.kind = PatternKind::Zero;
+                pass.bytes.clear();
+            }
+        } else {
+            error = "Invalid pattern '" + name + "'. Use zero, one, random, crypto or hex bytes (e.g. 0x55AA).";
+            return false;
+        }
+        passes.push_back(pass);
+    }
+
+    if (passes.empty()) {
+        error = "Option --pattern requires at least one pattern.";
+        return false;
+    }
+    return true;
+}
+
+// Ziarno całego uruchomienia z getrandom (przy braku – z zegara i PID), gdy nie podano --pattern-seed
+uint64_t random_pattern_seed() {
+    uint64_t seed = 0;
+    if (getrandom(&seed, sizeof(seed), 0) != static_cast<ssize_t>(sizeof(seed))) {
+        seed = splitmix64_word(static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count()),
+                               static_cast<uint64_t>(getpid()));
+    }
+    return seed;
+}
+
+// Ziarno/klucz przebiegu wyprowadzane z ziarna uruchomienia i numeru przebiegu, więc drukowane ziarno
+// (--pattern-seed) odtwarza wszystkie przebiegi, także przy późniejszej weryfikacji --verify-only
+void seed_pattern(PassPattern& pass, uint64_t run_seed, uint64_t pass_index) {
+    constexpr uint64_t words_per_pass = 1 + sizeof(pass.key) / (sizeof(uint64_t));
+    pass.seed = splitmix64_word(run_seed, pass_index * words_per_pass);
+    for (uint64_t word_index = 1; word_index < words_per_pass; ++word_index) {
+        const uint64_t word = splitmix64_word(run_seed, pass_index * words_per_pass + word_index);
+        std::memcpy(reinterpret_cast<unsigned char*>(pass.key) + (word_index - 1) * sizeof(word), &word, sizeof(word));
+    }
+}
+
+// Dopasowanie opcji z wartością: "--name value" albo "--name=value"
+bool match_option_value(const std::string& option, const char* name, int argc, char* argv[], int& arg_index, std::string& value) {
+    const std::string prefix = std::string(name) + "=";
+    if (option.rfind(prefix, 0) == 0) {
+        value = option.substr(prefix.size());
+        return true;
+    }
+
+    if (option == name) {
+        value = arg_index + 1 < argc ? argv[++arg_index] : "";
+        return true;
+    }
+
+    return false;
+}
+
+std::string format_bytes(unsigned long long bytes) {
+    static const char* units[] = {"B", "KB", "MB", "GB", "TB", "PB"};
+    double value = static_cast<double>(bytes);
+    size_t unit_index = 0;
+
+    while (value >= 1024.0 && unit_index < (sizeof(units) / sizeof(units[0])) - 1) {
+        value /= 1024.0;
+        ++unit_index;
+    }
+
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(2) << value << " " << units[unit_index];
+    return stream.str();
+}
+
+// Szczytowe zużycie pamięci procesu (RSS) od startu
+unsigned long long peak_rss_bytes() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<unsigned long long>(usage.ru_maxrss) * 1024;
+}
+
+// Weryfikacja próbkowa (--sample): wynik dla losowych bloków i przedziały ufności dla całego celu
+struct SampleEstimate {
+    unsigned long long samples = 0;
+    unsigned long long block_size = 0;
+    unsigned long long population = 0;
+    unsigned long long dirty_samples = 0;
+    // Niepełny ogon za ostatnim pełnym blokiem, który nie jest losowany
+    unsigned long long unsampled_tail = 0;
+    double confidence = 95.0;
+    double block_fraction = 0.0;
+    double block_low = 0.0;
+    double block_high = 0.0;
+    double byte_fraction = 0.0;
+    double byte_low = 0.0;
+    double byte_high = 0.0;
+};
+
+// Kwantyl rozkładu normalnego dla obsługiwanych poziomów ufności (--confidence)
+bool confidence_z_score(double confidence, double& z_score) {
+    static const std::pair<double, double> levels[] = {{80.0, 1.2816}, {90.0, 1.6449}, {95.0, 1.9600}, {99.0, 2.5758}, {99.9, 3.2905}};
+    for (const auto& level : levels) {
+        if (std::fabs(level.first - confidence) < 1e-9) {
+            z_score = level.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Losowe numery bloków bez powtórzeń, posortowane rosnąco, by odczyt szedł jednym przejściem głowic
+std::vector<unsigned long long> pick_sample_blocks(unsigned long long population, unsigned long long count) {
+    uint64_t seed = 0;
+    if (getrandom(&seed, sizeof(seed), 0) != static_cast<ssize_t>(sizeof(seed))) {
+        seed = splitmix64_word(static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count()),
+                               static_cast<uint64_t>(getpid()));
+    }
+
+    std::vector<unsigned long long> blocks;
+    uint64_t draw = 0;
+    count = std::min(count, population);
+    while (blocks.size() < count) {
+        for (unsigned long long missing = count - blocks.size(); missing > 0; --missing) {
+            blocks.push_back(splitmix64_word(seed, draw++) % population);
+        }
+        std::sort(blocks.begin(), blocks.end());
+        blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    }
+    return blocks;
+}
+
+bool verify_target_sample(
+    int fd,
+    unsigned long long target_size,
+    const VerifyOptions& options,
+    unsigned long long sample_count,
+    size_t block_size,
+    double confidence,
+    bool show_progress,
+    VerificationStats& stats,
+    SampleEstimate& estimate,
+    std::string& error_message
+) {
+    const ZeroScanner& scanner = active_zero_scanner();
+    // Każda próba obejmuje dokładnie trial_size bajtów, a próby się nie nakładają: niepełny ogon za ostatnim
+    // pełnym blokiem nie należy do populacji (raport podaje jego rozmiar)
+    const size_t trial_size = static_cast<size_t>(std::min<unsigned long long>(block_size, target_size));
+    const unsigned long long population = trial_size > 0 ? target_size / trial_size : 0;
+    const std::vector<unsigned long long> blocks = pick_sample_blocks(population, sample_count);
+
+    // Wątki pobierają kolejne bloki z posortowanej listy; udział !00 w bloku jest potrzebny do wariancji
+    std::vector<VerificationStats> shard_stats(options.threads);
+    std::vector<std::pair<double, double>> shard_moments(options.threads);
+    std::vector<unsigned long long> shard_dirty(options.threads, 0);
+    std::atomic<size_t> next_block{0};
+    std::atomic<size_t> done_blocks{0};
+    std::atomic<unsigned> finished_workers{0};
+    std::atomic<bool> failed{false};
+    stats = VerificationStats{};
+
+    auto worker = [&](unsigned worker_index) {
+        AlignedBuffer buffer(block_size, options.direct_alignment);
+        VerificationStats& local = shard_stats[worker_index];
+        while (keep_running && !failed.load(std::memory_order_relaxed)) {
+            const size_t index = next_block.fetch_add(1, std::memory_order_relaxed);
+            if (index >= blocks.size()) {
+                break;
+            }
+
+            const unsigned long long offset = blocks[index] * trial_size;
+            const size_t length = trial_size;
+            const ssize_t read_result = read_paced_chunk(fd, buffer.data, offset, length, options.direct_alignment,
+                                                         options.throttle, options.read_latency);
+            if (read_result < 0 || static_cast<size_t>(read_result) < length) {
+                if (options.error_log != nullptr) {
+                    options.error_log->record(offset, read_result < 0 ? errno : EIO);
+                }
+                failed = true;
+                break;
+            }
+
+            const ZeroScanResult scan = scanner.scan(buffer.data, length, false);
+            if (scan.first_non_zero != ZeroScanResult::npos) {
+                local.first_non_zero_offset = std::min(local.first_non_zero_offset, offset + scan.first_non_zero);
+                ++shard_dirty[worker_index];
+            }
+            const double fraction = static_cast<double>(scan.non_zero_bytes) / length;
+            shard_moments[worker_index].first += fraction;
+            shard_moments[worker_index].second += fraction * fraction;
+            local.non_zero_bytes += scan.non_zero_bytes;
+            local.bytes_read += length;
+            done_blocks.fetch_add(1, std::memory_order_relaxed);
+        }
+        finished_workers.fetch_add(1, std::memory_order_release);
+    };
+
+    auto verify_start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned worker_index = 0; worker_index < options.threads; ++worker_index) {
+        workers.emplace_back(worker, worker_index);
+    }
+
+    while (finished_workers.load(std::memory_order_acquire) < options.threads) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const size_t done = done_blocks.load(std::memory_order_relaxed);
+        const double percentage = blocks.empty() ? 100.0 : (done * 100.0) / blocks.size();
+        if (options.progress != nullptr) {
+            options.progress->processed_bytes.store(done * trial_size, std::memory_order_relaxed);
+        }
+        if (show_progress) {
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - verify_start;
+            print_verification_progress(percentage, elapsed.count() > 0.0 ? (done * trial_size / (1024.0 * 1024.0)) / elapsed.count() : 0.0);
+        }
+    }
+
+    for (std::thread& worker_thread : workers) {
+        worker_thread.join();
+    }
+
+    if (failed) {
+        error_message = "Read error while sampling target content.";
+        return false;
+    }
+
+    double fraction_sum = 0.0;
+    double fraction_squares = 0.0;
+    estimate = SampleEstimate{};
+    for (unsigned worker_index = 0; worker_index < options.threads; ++worker_index) {
+        const VerificationStats& local = shard_stats[worker_index];
+        stats.bytes_read += local.bytes_read;
+        stats.non_zero_bytes += local.non_zero_bytes;
+        stats.first_non_zero_offset = std::min(stats.first_non_zero_offset, local.first_non_zero_offset);
+        fraction_sum += shard_moments[worker_index].first;
+        fraction_squares += shard_moments[worker_index].second;
+        estimate.dirty_samples += shard_dirty[worker_index];
+    }
+    stats.zero_bytes = stats.bytes_read - stats.non_zero_bytes;
+    stats.duration_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - verify_start).count();
+
+    double z = 0.0;
+    confidence_z_score(confidence, z);
+    const double n = static_cast<double>(done_blocks.load());
+    estimate.samples = done_blocks.load();
+    estimate.block_size = trial_size;
+    estimate.population = population;
+    estimate.unsampled_tail = target_size - population * trial_size;
+    estimate.confidence = confidence;
+    if (estimate.samples == 0) {
+        return true;
+    }
+
+    // Udział bloków z bajtami !00: przedział Wilsona (poprawny także przy 0 trafień)
+    const double p = estimate.dirty_samples / n;
+    const double denominator = 1.0 + z * z / n;
+    const double center = (p + z * z / (2.0 * n)) / denominator;
+    const double half_width = z * std::sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n)) / denominator;
+    estimate.block_fraction = p;
+    estimate.block_low = std::max(0.0, center - half_width);
+    estimate.block_high = std::min(1.0, center + half_width);
+
+    // Udział bajtów !00: średnia udziałów w blokach z poprawką na skończoną populację; przy kilku trafieniach
+    // przybliżenie normalne zawodzi, więc górną granicą zostaje udział brudnych bloków (bajtów !00 nie może być więcej)
+    const double mean = fraction_sum / n;
+    const double variance = n > 1.0 ? std::max(0.0, (fraction_squares - n * mean * mean) / (n - 1.0)) : 0.0;
+    const double correction = population > 1 ? std::max(0.0, 1.0 - n / population) : 0.0;
+    const double standard_error = std::sqrt(variance / n * correction);
+    estimate.byte_fraction = mean;
+    estimate.byte_low = std::max(0.0, mean - z * standard_error);
+    estimate.byte_high = estimate.dirty_samples < 5 ? estimate.block_high
+                                                    : std::min(estimate.block_high, mean + z * standard_error);
+    return true;
+}
+
+void print_sample_estimate(unsigned long long target_size, const SampleEstimate& estimate) {
+    std::cout << "\nSampling estimate for the whole target (" << std::fixed << std::setprecision(1) << estimate.confidence
+              << "% confidence):" << std::endl;
+    std::cout << "  Samples: " << estimate.samples << " random blocks of " << format_bytes(estimate.block_size)
+              << " (" << std::setprecision(4) << (estimate.population > 0 ? (estimate.samples * 100.0) / estimate.population : 0.0)
+              << "% of target)" << std::endl;
+    if (estimate.unsampled_tail > 0) {
+        std::cout << "  Not sampled: last " << format_bytes(estimate.unsampled_tail) << " (shorter than one block)" << std::endl;
+    }
+    std::cout << "  Blocks with non-zero bytes: " << estimate.dirty_samples << " of " << estimate.samples << " ("
+              << estimate.block_fraction * 100.0 << "%), whole target: " << estimate.block_low * 100.0 << "% - "
+              << estimate.block_high * 100.0 << "%" << std::endl;
+    std::cout << "  Non-zero bytes: " << estimate.byte_fraction * 100.0 << "% (" << estimate.byte_low * 100.0 << "% - "
+              << estimate.byte_high * 100.0 << "%), about " << format_bytes(static_cast<unsigned long long>(estimate.byte_fraction * target_size))
+              << " (" << format_bytes(static_cast<unsigned long long>(estimate.byte_low * target_size)) << " - "
+              << format_bytes(static_cast<unsigned long long>(estimate.byte_high * target_size)) << ")" << std::endl;
+    if (estimate.dirty_samples == 0) {
+        std::cout << "  No non-zero bytes in the sample; a full --verify-only is needed to prove the target is clean." << std::endl;
+    }
+}
+
+void print_help(const char* program_name) {
+    std::cout << "Usage:\n";
+    std::cout << "  " << program_name << " <device_or_file> <erase_size_MB> <skip_size_MB> [options]\n";
+    std::cout << "  " << program_name << " @<manifest_file> <erase_size_MB> <skip_size_MB> [options]\n\n";
+    std::cout << "Arguments:\n";
+    std::cout << "  <device_or_file>   Target block device (e.g. /dev/sdb) or file for simulation\n";
+    std::cout << "  <erase_size_MB>    Size of zeroed chunk in MB (must be > 0)\n";
+    std::cout << "  <skip_size_MB>     Size of skipped chunk in MB\n";
+    std::cout << "  @<manifest_file>   File listing targets (one per line) for batch erase\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --simulate         Simulation mode (no writes are performed)\n";
+    std::cout << "  --verify-zero      Scan target and verify bytes are 00 before erase\n";
+    std::cout << "  --verify-only      Verify target and print usage report (no erase)\n";
+    std::cout << "  --direct           Bypass page cache (O_DIRECT) for erase and verification\n";
+    std::cout << "  --offload[=MODE]   Let kernel/device zero ranges: zeroout (default, WRITE ZEROES);\n";
+    std::cout << "                     regular files use fallocate ZERO_RANGE. discard and secure-discard\n";
+    std::cout << "                     do not guarantee zeroes: kernels report discard_zeroes_data=0, so\n";
+    std::cout << "                     they fall back to zeroout unless the device reports 1\n";
+    std::cout << "  --skip-holes       Do not rewrite holes of sparse files (they already read as 00)\n";
+    std::cout << "  --sample N         With --verify-only: read N random blocks and estimate the non-zero fraction\n";
+    std::cout << "  --sample-block KB  Size of one sampled block in KB (4-65536, default 64)\n";
+    std::cout << "  --confidence P     Confidence level of --sample bounds: 80, 90, 95 (default), 99 or 99.9\n";
+    std::cout << "  --map FILE         With --verify-only: write non-zero extents and density map (JSON)\n";
+    std::cout << "  --map-grain KB     Extent map granularity in KB, power of two (default 1024)\n";
+    std::cout << "  --erase-map FILE   Erase only non-zero extents listed in a map from --map\n";
+    std::cout << "  --skip-clean       Read each chunk first and write only chunks with non-zero bytes\n";
+    std::cout << "  --erase-verify     Read back erased chunks (O_DIRECT) while later ones are written\n";
+    std::cout << "  --metadata-first   Zero partition tables, superblocks and LUKS/LVM headers before the sweep\n";
+    std::cout << "  --pattern LIST     Comma-separated passes: zero, one, random, crypto or hex bytes (0x55AA)\n";
+    std::cout << "  --passes N         Repeat the --pattern list N times (1-100, default 1)\n";
+    std::cout << "  --pattern-seed S   Seed of random/crypto passes (decimal or 0x hex; default random, printed);\n";
+    std::cout << "                     with --verify-only checks the target against the last pass\n";
+    std::cout << "  --gen-threads N    Threads generating pattern data ahead of writes (1-64, default: CPUs up to 8)\n";
+    std::cout << "  --auto-tune        Pick I/O size and depth from device queue limits and a short read probe\n";
+    std::cout << "  --bench            Benchmark erase/verify on a scratch file or device (overwrites it)\n";
+    std::cout << "  --bench-size MB    Bytes written and read per benchmark run (default 256)\n";
+    std::cout << "  --bench-chunks LIST  Chunk sizes in KB, e.g. 64,1024,4096 (default erase_size_MB)\n";
+    std::cout << "  --bench-threads LIST Verification thread counts, e.g. 1,4 (default --threads)\n";
+    std::cout << "  --bench-modes LIST I/O modes: sync, sync-direct, io_uring, io_uring-direct, null (default all)\n";
+    std::cout << "  --bench-format FMT Benchmark results as csv (default) or json\n";
+    std::cout << "  --bench-output FILE  Write benchmark results to FILE instead of stdout\n";
+    std::cout << "  --stats-json FILE  Stream JSON Lines telemetry (progress every second, final summary) to FILE\n";
+    std::cout << "  --stats-fd N       Stream the same telemetry to an open file descriptor (e.g. 3 with 3>stats.jsonl)\n";
+    std::cout << "  --sync-window MB   Start writeback every MB written and keep at most two windows dirty\n";
+    std::cout << "  --max-rate MB      Limit erase and verification I/O to MB per second (paced, not bursty)\n";
+    std::cout << "  --max-iops N       Limit erase and verification I/O to N requests per second\n";
+    std::cout << "  --rate-file FILE   Reload limits while running from FILE (\"max-rate=MB max-iops=N\", 0 = unlimited)\n";
+    std::cout << "  --ioprio CLASS     I/O priority: idle, be[:0-7] or rt[:0-7] (needs a scheduler that honours it)\n";
+    std::cout << "  --threads N        Verification threads reading in parallel (1-256, default 1)\n";
+    std::cout << "  --verify-chunk MB  Verification and --skip-clean read size in MB (default 4)\n";
+    std::cout << "  --verify-buffers N Read-ahead buffers for verification and --skip-clean (2-64, default 4)\n";
+    std::cout << "  --target DEV       Add another target; several targets are erased concurrently\n";
+    std::cout << "  --journal FILE     Record durable erase checkpoints in FILE\n";
+    std::cout << "  --journal-interval SEC  Seconds between journal checkpoints (default 10)\n";
+    std::cout << "  --resume           Continue erase from the checkpoint in --journal FILE\n";
+    std::cout << "  --group-inflight N Batch: writes in flight per controller group (default 8)\n";
+    std::cout << "  --engine=NAME      Erase engine: sync (default) or io_uring\n";
+    std::cout << "  --queue-depth N    Writes in flight for io_uring engine (1-4096, default 32)\n";
+    std::cout << "  --writers N        Erase with N threads, each using pwrite on its own descriptor (1-256, default 1)\n";
+    std::cout << "  --writer-layout L  Split chunks between writers: interleaved (default) or contiguous ranges\n";
+    std::cout << "  -q, --quiet-errors Print one-line errors only (no full help on error)\n";
+    std::cout << "  -h, --help         Show this help message\n\n";
+    std::cout << "Exit codes:\n";
+    std::cout << "  0  Success\n";
+    std::cout << "  2  Invalid arguments or values\n";
+    std::cout << "  3  Open target failed\n";
+    std::cout << "  4  Could not determine target size\n";
+    std::cout << "  5  Seek failed\n";
+    std::cout << "  6  Write failed (or read-back found unexpected bytes)\n";
+    std::cout << "  7  User aborted operation\n\n";
+    std::cout << "Examples:\n";
+    std::cout << "  " << program_name << " /dev/sdb 8 0\n";
+    std::cout << "  " << program_name << " /dev/sdb 8 8\n";
+    std::cout << "  " << program_name << " /dev/sdb 1 99 --metadata-first\n";
+    std::cout << "  " << program_name << " /dev/sdb 8 0 --verify-zero\n";
+    std::cout << "  " << program_name << " /dev/sdb 1 0 --verify-only\n";
+    std::cout << "  " << program_name << " /dev/sdb 1 0 --verify-only --sample 20000 --threads 4\n";
+    std::cout << "  " << program_name << " /dev/nvme0n1 8 0 --engine=io_uring --queue-depth 64\n";
+    std::cout << "  " << program_name << " /dev/md0 8 0 --writers 8 --writer-layout contiguous\n";
+    std::cout << "  " << program_name << " /dev/sdb 8 0 --target /dev/sdc --target /dev/sdd\n";
+    std::cout << "  " << program_name << " @shelf.txt 8 0 --group-inflight 4\n";
+    std::cout << "  " << program_name << " scratch.img 4 0 --bench --bench-chunks 64,1024,4096 --bench-threads 1,4\n";
+    std::cout << "  " << program_name << " /dev/sdb 8 0 --stats-fd 3 3>stats.jsonl\n";
+    std::cout << "  " << program_name << " /dev/sdb 8 0 --max-rate 100 --rate-file /run/eraser.rate --ioprio idle\n";
+    std::cout << "  " << program_name << " test.img 4 4 --simulate\n";
+    std::cout << "  " << program_name << " test.img abc 4 --simulate --quiet-errors\n";
+}
+
+void print_error(const char* program_name, const std::string& message, bool quiet_errors) {
+    std::cerr << "Error: " << message << std::endl;
+    if (!quiet_errors) {
+        print_help(program_name);
+    }
+}
+
+// Obsługa sygnału Ctrl+C
+void handle_signal(int signal) {
+    if (signal == SIGINT) {
+        keep_running = false;
+        std::cout << "\nProcess interrupted by user. Exiting..." << std::endl;
+    }
+}
+
+// Pobieranie modelu i producenta dysku
+std::string get_disk_info(const std::string& device) {
+    if (device.rfind("/dev/", 0) != 0) {
+        return "N/A";
+    }
+
+    std::string model, vendor;
+    std::ifstream vendor_file("/sys/block/" + device.substr(5) + "/device/vendor");
+    std::ifstream model_file("/sys/block/" + device.substr(5) + "/device/model");
+
+    if (vendor_file) {
+        std::getline(vendor_file, vendor);
+    }
+    if (model_file) {
+        std::getline(model_file, model);
+    }
+
+    return vendor + " " + model;
+}
+
+// Niepowtarzalny identyfikator celu dla dziennika wznowienia: numer seryjny albo WWID z sysfs (dla partycji
+// z dysku nadrzędnego, z numerem partycji), w ostatniej kolejności st_rdev; dla pliku st_dev/st_ino.
+// Pusty, gdy nie da się go ustalić
+std::string get_target_unique_id(int fd) {
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        return "";
+    }
+    if (S_ISREG(st.st_mode)) {
+        return "inode=" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev)) + ":" + std::to_string(st.st_ino);
+    }
+    if (!S_ISBLK(st.st_mode)) {
+        return "";
+    }
+
+    auto read_trimmed = [](const std::string& path) {
+        std::string value;
+        std::ifstream file(path);
+        if (file) {
+            std::getline(file, value);
+        }
+        const size_t first = value.find_first_not_of(" \t");
+        const size_t last = value.find_last_not_of(" \t");
+        return first == std::string::npos ? std::string() : value.substr(first, last - first + 1);
+    };
+
+    const std::string block_path = "/sys/dev/block/" + std::to_string(major(st.st_rdev)) + ":" + std::to_string(minor(st.st_rdev));
+    const std::string partition = read_trimmed(block_path + "/partition");
+    const std::string disk_path = partition.empty() ? block_path : block_path + "/..";
+    const std::string suffix = partition.empty() ? "" : " part=" + partition;
+    static const char* const attributes[][2] = {
+        {"/device/serial", "serial="}, {"/wwid", "wwid="}, {"/device/wwid", "wwid="}};
+    for (const auto& attribute : attributes) {
+        const std::string value = read_trimmed(disk_path + attribute[0]);
+        if (!value.empty()) {
+            return attribute[1] + value + suffix;
+        }
+    }
+    return "rdev=" + std::to_string(major(st.st_rdev)) + ":" + std::to_string(minor(st.st_rdev));
+}
+
+// Odczyt atrybutu kolejki bloku z sysfs (dla partycji z urządzenia nadrzędnego)
+std::string read_block_queue_attribute(const std::string& device, const std::string& attribute) {
+    if (device.rfind("/dev/", 0) != 0) {
+        return "";
+    }
+
+    const std::string block_path = "/sys/class/block/" + device.substr(5);
+    std::string value;
+    std::ifstream attribute_file(block_path + "/queue/" + attribute);
+    if (!attribute_file) {
+        attribute_file.open(block_path + "/../queue/" + attribute);
+    }
+    if (attribute_file) {
+        std::getline(attribute_file, value);
+    }
+    return value;
+}
+
+// Pobieranie rodzaju dysku (SATA, NVMe, USB)
+std::string get_disk_type(const std::string& device) {
+    if (device.find("nvme") != std::string::npos) return "NVMe";
+    if (device.find("sd") != std::string::npos) return "SATA/USB";
+    return "Unknown";
+}
+
+// Wyrównanie dla O_DIRECT: sektor fizyczny (min. logiczny) urządzenia albo blok systemu plików
+size_t get_direct_io_alignment(int fd) {
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && S_ISBLK(st.st_mode)) {
+        int logical_sector = 0;
+        unsigned int physical_sector = 0;
+        if (ioctl(fd, BLKSSZGET, &logical_sector) < 0 || logical_sector <= 0) {
+            logical_sector = 512;
+        }
+        if (ioctl(fd, BLKPBSZGET, &physical_sector) < 0) {
+            physical_sector = 0;
+        }
+        return std::max<size_t>(static_cast<size_t>(logical_sector), physical_sector);
+    }
+
+    if (st.st_blksize > 0 && (st.st_blksize & (st.st_blksize - 1)) == 0) {
+        return static_cast<size_t>(st.st_blksize);
+    }
+    return 4096;
+}
+
+// Grupa kontrolera (HBA) dysku: rodzaj dysku + ostatni adres PCI na ścieżce urządzenia w sysfs
+std::string get_controller_group(const std::string& device) {
+    const std::string disk_type = get_disk_type(device);
+    if (device.rfind("/dev/", 0) != 0) {
+        return disk_type + "@file";
+    }
+
+    char resolved[PATH_MAX];
+    const std::string sysfs_path = "/sys/class/block/" + device.substr(5);
+    if (realpath(sysfs_path.c_str(), resolved) == nullptr) {
+        return disk_type + "@unknown";
+    }
+
+    std::string controller = "unknown";
+    std::stringstream path_stream(resolved);
+    std::string component;
+    while (std::getline(path_stream, component, '/')) {
+        // Adres PCI w postaci dddd:bb:ss.f
+        const bool pci_address = component.size() == 12 && component[4] == ':' && component[7] == ':' && component[10] == '.'
+            && std::all_of(component.begin(), component.end(), [](unsigned char character) {
+                   return std::isxdigit(character) || character == ':' || character == '.';
+               });
+        if (pci_address) {
+            controller = component;
+        }
+    }
+
+    return disk_type + "@" + controller;
+}
+
+// Odliczanie przed startem
+void countdown() {
+    for (int i = 5; i > 0; --i) {
+        if (!keep_running) return;
+        std::cout << "\rStarting in " << i << "... ";
+        std::cout.flush();
+        sleep(1);
+    }
+    std::cout << "Start!" << std::endl;
+}
+
+// Wyświetlanie progresu
+void print_progress(double percentage, double speed, double erased_percentage, const std::string& label = "") {
+    if (!progress_refresh_due(percentage)) {
+        return;
+    }
+    std::cout << "\r\033[K" << label << "Progress: " << std::fixed << std::setprecision(2) << percentage
+              << "% | Erased: " << erased_percentage
+              << "% | Speed: " << speed << " MB/s";
+    std::cout.flush();
+}
+
+void report_erase_progress(
+    const EraseOptions& options,
+    const std::chrono::high_resolution_clock::time_point& start_time,
+    unsigned long long processed_bytes,
+    const EraseStats& stats,
+    unsigned long long device_size
+) {
+    const unsigned long long total_erased = stats.total_erased;
+    if (options.progress != nullptr) {
+        options.progress->processed_bytes.store(processed_bytes, std::memory_order_relaxed);
+        options.progress->erased_bytes.store(total_erased, std::memory_order_relaxed);
+    }
+
+    if (!options.show_progress) {
+        return;
+    }
+
+    auto current_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = current_time - start_time;
+    double percentage = (double)processed_bytes / device_size * 100.0;
+    double erased_percentage = (double)total_erased / device_size * 100.0;
+    double speed = elapsed.count() > 0.0 ? ((total_erased - stats.resumed_bytes) / (1024.0 * 1024.0)) / elapsed.count() : 0.0;
+
+    print_progress(percentage, speed, erased_percentage);
+}
+
+// Przeliczenie nadpisanych bajtów na pozycję w cyklu erase/skip
+unsigned long long processed_bytes_for_erased(
+    unsigned long long total_erased,
+    size_t erase_size,
+    size_t skip_size,
+    unsigned long long device_size
+) {
+    const unsigned long long full_chunks = total_erased / erase_size;
+    const unsigned long long partial = total_erased % erase_size;
+    const unsigned long long stride = static_cast<unsigned long long>(erase_size) + skip_size;
+    return std::min<unsigned long long>(full_chunks * stride + partial, device_size);
+}
+
+// Liczba bajtów nadpisywanych w cyklu erase/skip przed podanym offsetem
+unsigned long long erased_bytes_before(unsigned long long position, size_t erase_size, size_t skip_size) {
+    const unsigned long long stride = static_cast<unsigned long long>(erase_size) + skip_size;
+    return (position / stride) * erase_size + std::min<unsigned long long>(position % stride, erase_size);
+}
+
+// Zapis nierównego ogona (np. pliku o rozmiarze niepodzielnym przez sektor) z chwilowo wyłączonym O_DIRECT
+bool write_buffered_tail(int fd, unsigned long long offset, const char* data, size_t length) {
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) < 0) {
+        perror("Error switching off O_DIRECT for unaligned tail");
+        return false;
+    }
+
+    size_t bytes_written = 0;
+    bool success = true;
+    while (bytes_written < length) {
+        const ssize_t write_result = pwrite(fd, data + bytes_written, length - bytes_written,
+                                            static_cast<off_t>(offset + bytes_written));
+        if (write_result < 0) {
+            perror("Error writing to device");
+            success = false;
+            break;
+        }
+
+        if (write_result == 0) {
+            std::cerr << "Error: no data written to device." << std::endl;
+            success = false;
+            break;
+        }
+
+        bytes_written += static_cast<size_t>(write_result);
+    }
+
+    // Ogon przeszedł przez cache stron, więc trzeba go jawnie wypchnąć na nośnik
+    if (success && fdatasync(fd) < 0) {
+        perror("Error syncing unaligned tail");
+        success = false;
+    }
+
+    fcntl(fd, F_SETFL, flags);
+    return success;
+}
+
+// Okno zapisu zwrotnego (--sync-window): po każdym oknie zapisanych bajtów jądro dostaje sync_file_range(WRITE)
+// na ten zakres, a na zapis poprzedniego okna czekamy, więc w cache stron są najwyżej dwa okna brudnych danych
+struct WritebackWindow {
+    int fd;
+    unsigned long long window;
+    unsigned long long range_start = 0;
+    unsigned long long range_end = 0;
+    unsigned long long range_bytes = 0;
+    unsigned long long previous_start = 0;
+    unsigned long long previous_end = 0;
+    IoErrorLog* error_log;
+
+    WritebackWindow(int target_fd, unsigned long long window_bytes, IoErrorLog* log = nullptr)
+        : fd(target_fd), window(window_bytes), error_log(log) {}
+
+    bool sync_range(unsigned long long start, unsigned long long end, unsigned int flags) {
+        if (sync_file_range(fd, static_cast<off64_t>(start), static_cast<off64_t>(end - start), flags) == 0) {
+            return true;
+        }
+        if (errno == EINVAL || errno == ESPIPE || errno == ENOSYS) {
+            std::cerr << "\nWarning: sync_file_range is not supported by target (" << std::strerror(errno)
+                      << "), --sync-window ignored." << std::endl;
+            window = 0;
+            return true;
+        }
+        if (error_log != nullptr) {
+            error_log->record(start, errno);
+        }
+        perror("Error writing back erased data");
+        return false;
+    }
+
+    // Zapisy mogą kończyć się poza kolejnością (io_uring), więc okno obejmuje zakres od najmniejszego do największego offsetu
+    bool wrote(unsigned long long offset, unsigned long long length) {
+        if (window == 0 || length == 0) {
+            return true;
+        }
+        range_start = range_bytes == 0 ? offset : std::min(range_start, offset);
+        range_end = range_bytes == 0 ? offset + length : std::max(range_end, offset + length);
+        range_bytes += length;
+        if (range_bytes < window) {
+            return true;
+        }
+
+        if (!sync_range(range_start, range_end, SYNC_FILE_RANGE_WRITE)) {
+            return false;
+        }
+        if (window > 0 && previous_end > previous_start
+            && !sync_range(previous_start, previous_end,
+                           SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER)) {
+            return false;
+        }
+        previous_start = range_start;
+        previous_end = range_end;
+        range_bytes = 0;
+        return true;
+    }
+};
+
+// Zapis danych z cache na nośnik przed zgłoszeniem zakończenia; czas synchronizacji wlicza się do czasu kasowania
+int sync_erased_target(int fd, const EraseOptions& options, EraseStats& stats) {
+    const unsigned long long sync_start = monotonic_ns();
+    if (fdatasync(fd) < 0 && errno != EINVAL) {
+        if (options.error_log != nullptr) {
+            options.error_log->record(0, errno);
+        }
+        perror("Error syncing erased data to target");
+        return EXIT_WRITE_FAILED;
+    }
+    stats.sync_seconds = (monotonic_ns() - sync_start) / 1e9;
+    stats.duration_seconds += stats.sync_seconds;
+    return EXIT_OK;
+}
+
+enum class OffloadResult {
+    Done,
+    // Urządzenie/FS w ogóle nie obsługuje operacji – dalsze próby nie mają sensu
+    Unsupported,
+    // Odrzucony tylko ten zakres (EINVAL, np. wyrównanie ogona) – fragment idzie przez write, kolejne znów przez offload
+    Rejected,
+    Failed
+};
+
+const char* offload_mode_name(OffloadMode mode, bool block_device) {
+    if (!block_device) {
+        return "fallocate(FALLOC_FL_ZERO_RANGE)";
+    }
+    switch (mode) {
+        case OffloadMode::Discard:
+            return "BLKDISCARD";
+        case OffloadMode::SecureDiscard:
+            return "BLKSECDISCARD";
+        default:
+            return "BLKZEROOUT";
+    }
+}
+
+// Zerowanie zakresu po stronie jądra/urządzenia (WRITE ZEROES, discard albo fallocate)
+OffloadResult offload_zero_range(int fd, OffloadMode mode, bool block_device, unsigned long long offset, unsigned long long length) {
+    int result = -1;
+    if (block_device) {
+        uint64_t range[2] = {offset, length};
+        unsigned long request = BLKZEROOUT;
+        if (mode == OffloadMode::Discard) {
+            request = BLKDISCARD;
+        } else if (mode == OffloadMode::SecureDiscard) {
+            request = BLKSECDISCARD;
+        }
+        result = ioctl(fd, request, &range);
+    } else {
+        result = fallocate(fd, FALLOC_FL_ZERO_RANGE, static_cast<off_t>(offset), static_cast<off_t>(length));
+    }
+
+    if (result == 0) {
+        return OffloadResult::Done;
+    }
+
+    if (errno == EOPNOTSUPP || errno == ENOTTY || errno == ENOSYS || errno == ENODEV) {
+        return OffloadResult::Unsupported;
+    }
+    if (errno == EINVAL) {
+        return OffloadResult::Rejected;
+    }
+    return OffloadResult::Failed;
+}
+
+// Pierwszy bajt >= position, który przebieg faktycznie zapisuje (wzór erase/skip, wznowienie, data_extents)
+unsigned long long next_erased_position(
+    unsigned long long position,
+    unsigned long long device_size,
+    size_t erase_size,
+    size_t skip_size,
+    const EraseOptions& options
+) {
+    const unsigned long long stride = static_cast<unsigned long long>(erase_size) + skip_size;
+    position = std::max(position, options.start_offset);
+    while (position < device_size) {
+        const unsigned long long chunk_position = position % stride;
+        if (chunk_position >= erase_size) {
+            position += stride - chunk_position;
+            continue;
+        }
+
+        const unsigned long long chunk_end = std::min(position - chunk_position + erase_size, device_size);
+        if (options.data_extents == nullptr) {
+            return position;
+        }
+
+        unsigned long long hole_length = 0;
+        unsigned long long data_length = 0;
+        split_at_holes(*options.data_extents, position, chunk_end, hole_length, data_length);
+        if (data_length > 0) {
+            return position + hole_length;
+        }
+
+        // Za fragmentem bez danych przeskakujemy od razu do następnego zakresu
+        auto extent = std::upper_bound(options.data_extents->begin(), options.data_extents->end(), chunk_end,
+            [](unsigned long long value, const DataExtent& candidate) {
+                return value < candidate.offset + candidate.length;
+            });
+        position = extent == options.data_extents->end() ? device_size : std::max(chunk_end, extent->offset);
+    }
+    return device_size;
+}
+
+// Generator danych wzorca: wątki robocze z wyprzedzeniem wypełniają pierścień okien (wyrównanych kawałków nośnika),
+// a silnik kasowania pobiera gotowe okno dla zapisywanego offsetu, więc generowanie nie ogranicza zapisu
+struct PatternFeed {
+    static constexpr size_t window_size = 1024 * 1024;
+
+    enum class WindowState {
+        Free,
+        Filling,
+        Ready
+    };
+
+    struct Window {
+        unsigned long long index = 0;
+        WindowState state = WindowState::Free;
+        unsigned users = 0;
+        std::unique_ptr<AlignedBuffer> buffer;
+    };
+
+    using NextPosition = std::function<unsigned long long(unsigned long long position)>;
+
+    const PassPattern& pattern;
+    unsigned long long device_size;
+    NextPosition next_position;
+    std::vector<std::unique_ptr<Window>> windows;
+    std::vector<std::unique_ptr<Window>> extra_windows;
+    unsigned long long next_window = 0;
+    unsigned long long cursor = 0;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::thread> workers;
+
+    PatternFeed(const PassPattern& pass_pattern, unsigned long long target_size, NextPosition next_erased,
+                size_t window_count, unsigned thread_count, size_t alignment)
+        : pattern(pass_pattern), device_size(target_size), next_position(std::move(next_erased)) {
+        for (size_t index = 0; index < window_count; ++index) {
+            windows.emplace_back(new Window);
+            windows.back()->buffer.reset(new AlignedBuffer(window_size, alignment));
+        }
+        next_window = next_position(0) / window_size;
+        for (unsigned worker_index = 0; worker_index < thread_count; ++worker_index) {
+            workers.emplace_back(&PatternFeed::run_worker, this);
+        }
+    }
+
+    PatternFeed(const PatternFeed&) = delete;
+    PatternFeed& operator=(const PatternFeed&) = delete;
+
+    ~PatternFeed() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Okna za kursorem, z których nikt już nie korzysta, można wypełnić ponownie
+    Window* free_window() {
+        for (const std::unique_ptr<Window>& window : windows) {
+            if (window->state == WindowState::Free
+                || (window->state == WindowState::Ready && window->users == 0 && window->index < cursor)) {
+                return window.get();
+            }
+        }
+        return nullptr;
+    }
+
+    Window* find_window(unsigned long long index) {
+        for (const std::unique_ptr<Window>& window : windows) {
+            if (window->state != WindowState::Free && window->index == index) {
+                return window.get();
+            }
+        }
+        for (const std::unique_ptr<Window>& window : extra_windows) {
+            if (window->index == index) {
+                return window.get();
+            }
+        }
+        return nullptr;
+    }
+
+    void run_worker() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            Window* window = next_window * window_size < device_size ? free_window() : nullptr;
+            if (window == nullptr) {
+                changed.wait(lock);
+                continue;
+            }
+
+            window->index = next_window;
+            window->state = WindowState::Filling;
+            next_window = next_position((next_window + 1) * window_size) / window_size;
+
+            lock.unlock();
+            pattern.generate(window->buffer->data, window->index * window_size, window_size, false);
+            lock.lock();
+
+            window->state = WindowState::Ready;
+            changed.notify_all();
+        }
+    }
+
+    // Dane wzorca od offsetu do końca jego okna; blokuje, dopóki okno nie jest gotowe
+    const unsigned char* acquire(unsigned long long offset) {
+        const unsigned long long index = offset / window_size;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (index > cursor) {
+            cursor = index;
+            changed.notify_all();
+        }
+
+        while (true) {
+            Window* window = find_window(index);
+            if (window != nullptr && window->state == WindowState::Ready) {
+                ++window->users;
+                return window->buffer->data + offset % window_size;
+            }
+
+            // Okno spoza przewidzianej kolejności generujemy od razu, poza pierścieniem
+            if (window == nullptr && index < next_window) {
+                std::unique_ptr<Window> extra(new Window);
+                extra->index = index;
+                extra->state = WindowState::Ready;
+                extra->users = 1;
+                extra->buffer.reset(new AlignedBuffer(window_size, 0));
+                pattern.generate(extra->buffer->data, index * window_size, window_size, false);
+                const unsigned char* data = extra->buffer->data + offset % window_size;
+                extra_windows.push_back(std::move(extra));
+                return data;
+            }
+            changed.wait(lock);
+        }
+    }
+
+    void release(unsigned long long offset) {
+        const unsigned long long index = offset / window_size;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Window* window = find_window(index);
+            if (window != nullptr && window->users > 0 && --window->users == 0) {
+                extra_windows.erase(std::remove_if(extra_windows.begin(), extra_windows.end(),
+                    [](const std::unique_ptr<Window>& extra) { return extra->users == 0; }), extra_windows.end());
+            }
+        }
+        changed.notify_all();
+    }
+};
+
+// Zapis zakresu danymi z generatora, okno po oknie; nierówny ogon przy O_DIRECT idzie przez cache jak przy zerach
+int write_pattern_range(int fd, unsigned long long offset, size_t length, size_t direct_alignment, PatternFeed& feed,
+                        RateLimiter* throttle = nullptr) {
+    const unsigned long long end = offset + length;
+    const unsigned long long aligned_end = end - (direct_alignment > 0 ? length % direct_alignment : 0);
+    unsigned long long position = offset;
+
+    while (position < end) {
+        const unsigned long long window_end = (position / PatternFeed::window_size + 1) * PatternFeed::window_size;
+        const unsigned long long piece_end = std::min(window_end, position < aligned_end ? aligned_end : end);
+        const char* data = reinterpret_cast<const char*>(feed.acquire(position));
+
+        if (position >= aligned_end) {
+            const bool tail_written = write_buffered_tail(fd, position, data, static_cast<size_t>(piece_end - position));
+            feed.release(position);
+            if (!tail_written) {
+                return EXIT_WRITE_FAILED;
+            }
+            position = piece_end;
+            continue;
+        }
+
+        size_t bytes_written = 0;
+        const size_t piece_length = static_cast<size_t>(piece_end - position);
+        while (bytes_written < piece_length) {
+            size_t request_length = piece_length - bytes_written;
+            if (throttle != nullptr) {
+                request_length = throttle->request_size(request_length);
+                throttle->acquire(request_length);
+            }
+            const ssize_t write_result = pwrite(fd, data + bytes_written, request_length,
+                                                static_cast<off_t>(position + bytes_written));
+            if (write_result <= 0) {
+                feed.release(position);
+                if (write_result < 0) {
+                    perror("Error writing to device");
+                } else {
+                    std::cerr << "Error: no data written to device." << std::endl;
+                }
+                return EXIT_WRITE_FAILED;
+            }
+            bytes_written += static_cast<size_t>(write_result);
+        }
+
+        feed.release(position);
+        position = piece_end;
+    }
+    return EXIT_OK;
+}
+
+int erase_target_sync(
+    int fd,
+    unsigned long long device_size,
+    size_t erase_size,
+    size_t skip_size,
+    const EraseOptions& options,
+    EraseStats& stats
+) {
+    struct stat target_stat {};
+    const bool block_device = fstat(fd, &target_stat) == 0 && S_ISBLK(target_stat.st_mode);
+    bool offload_available = options.offload != OffloadMode::None && !options.simulate;
+    bool offload_rejected = false;
+
+    // Źródło zer (przy offloadzie alokowane dopiero, gdy jądro odmówi zerowania); bez io_size
+    // cały fragment idzie jednym writev, z io_size – wywołaniami tej wielkości
+    std::unique_ptr<ZeroSource> zeros;
+    const size_t write_size = options.io_size > 0 ? std::min(options.io_size, erase_size) : erase_size;
+    WritebackWindow writeback(fd, options.simulate ? 0 : options.sync_window, options.error_log);
+
+    const unsigned long long stride = static_cast<unsigned long long>(erase_size) + skip_size;
+    stats = EraseStats{};
+    stats.resumed_bytes = erased_bytes_before(options.start_offset, erase_size, skip_size);
+    stats.total_erased = stats.resumed_bytes;
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    for (unsigned long long offset = options.start_offset - options.start_offset % stride; offset < device_size && keep_running; offset += (erase_size + skip_size)) {
+        // Przy wznowieniu pierwszy fragment może zaczynać się w połowie
+        const unsigned long long chunk_end = std::min<unsigned long long>(offset + erase_size, device_size);
+        const unsigned long long write_offset = std::max(offset, options.start_offset);
+        if (write_offset >= chunk_end) {
+            continue;
+        }
+
+        IoBudgetSlot budget_slot(options.simulate ? nullptr : options.io_budget);
+        unsigned long long piece_offset = write_offset;
+        while (piece_offset < chunk_end) {
+            // Poza data_extents cel już czyta się jako 00, więc zapisywane są tylko te zakresy
+            size_t bytes_to_write = static_cast<size_t>(chunk_end - piece_offset);
+            if (options.data_extents != nullptr) {
+                unsigned long long hole_length = 0;
+                unsigned long long data_length = 0;
+                split_at_holes(*options.data_extents, piece_offset, chunk_end, hole_length, data_length);
+                stats.skipped_bytes += hole_length;
+                stats.total_erased += hole_length;
+                piece_offset += hole_length;
+                bytes_to_write = static_cast<size_t>(data_length);
+                if (bytes_to_write == 0) {
+                    break;
+                }
+            }
+
+            if (lseek(fd, piece_offset, SEEK_SET) < 0) {
+                perror("Error seeking device");
+                return EXIT_SEEK_FAILED;
+            }
+
+            bool chunk_offloaded = false;
+            if (offload_available) {
+                if (options.throttle != nullptr) {
+                    options.throttle->acquire(bytes_to_write);
+                }
+                const unsigned long long offload_start = monotonic_ns();
+                const OffloadResult offload_result = offload_zero_range(fd, options.offload, block_device, piece_offset, bytes_to_write);
+                if (options.write_latency != nullptr && offload_result == OffloadResult::Done) {
+                    options.write_latency->record(monotonic_ns() - offload_start);
+                }
+                if (offload_result == OffloadResult::Failed) {
+                    if (options.error_log != nullptr) {
+                        options.error_log->record(piece_offset, errno);
+                    }
+                    perror("Error zeroing range on device");
+                    return EXIT_WRITE_FAILED;
+                }
+
+                if (offload_result == OffloadResult::Done) {
+                    stats.offloaded_bytes += bytes_to_write;
+                    chunk_offloaded = true;
+                } else if (offload_result == OffloadResult::Unsupported) {
+                    std::cerr << "\nWarning: " << offload_mode_name(options.offload, block_device)
+                              << " is not supported by target (" << std::strerror(errno) << "), falling back to writes." << std::endl;
+                    offload_available = false;
+                } else if (!offload_rejected) {
+                    std::cerr << "\nWarning: " << offload_mode_name(options.offload, block_device)
+                              << " rejected a range (" << std::strerror(errno) << "), writing such chunks instead." << std::endl;
+                    offload_rejected = true;
+                }
+            }
+
+            if (!options.simulate && !chunk_offloaded && options.feed != nullptr) {
+                const unsigned long long write_start = monotonic_ns();
+                const int pattern_result = write_pattern_range(fd, piece_offset, bytes_to_write, options.direct_alignment, *options.feed,
+                                                             options.throttle);
+                if (pattern_result != EXIT_OK) {
+                    if (options.error_log != nullptr) {
+                        options.error_log->record(piece_offset, errno);
+                    }
+                    return pattern_result;
+                }
+                if (options.write_latency != nullptr) {
+                    options.write_latency->record(monotonic_ns() - write_start);
+                }
+                stats.written_bytes += bytes_to_write;
+            } else if (!options.simulate && !chunk_offloaded) {
+                if (zeros == nullptr) {
+                    zeros.reset(new ZeroSource(options.direct_alignment));
+                }
+
+                const size_t tail_bytes = options.direct_alignment > 0 ? bytes_to_write % options.direct_alignment : 0;
+                const size_t aligned_bytes = bytes_to_write - tail_bytes;
+                size_t bytes_written = 0;
+
+                while (bytes_written < aligned_bytes) {
+                    size_t request_length = std::min(write_size, aligned_bytes - bytes_written);
+                    if (options.throttle != nullptr) {
+                        request_length = options.throttle->request_size(request_length);
+                        options.throttle->acquire(request_length);
+                    }
+                    const unsigned long long write_start = options.write_latency != nullptr ? monotonic_ns() : 0;
+                    zeros->prepare(request_length);
+                    ssize_t write_result = writev(fd, zeros->vectors.data(), static_cast<int>(zeros->vectors.size()));
+                    if (write_result < 0) {
+                        if (options.error_log != nullptr) {
+                            options.error_log->record(piece_offset + bytes_written, errno);
+                        }
+                        perror("Error writing to device");
+                        return EXIT_WRITE_FAILED;
+                    }
+                    if (options.write_latency != nullptr) {
+                        options.write_latency->record(monotonic_ns() - write_start);
+                    }
+
+                    if (write_result == 0) {
+                        std::cerr << "Error: no data written to device." << std::endl;
+                        return EXIT_WRITE_FAILED;
+                    }
+
+                    bytes_written += static_cast<size_t>(write_result);
+                }
+
+                if (tail_bytes > 0 && !write_buffered_tail(fd, piece_offset + aligned_bytes, zeros->data(), tail_bytes)) {
+                    if (options.error_log != nullptr) {
+                        options.error_log->record(piece_offset + aligned_bytes, errno);
+                    }
+                    return EXIT_WRITE_FAILED;
+                }
+                stats.written_bytes += bytes_to_write;
+            }
+
+            if (!options.simulate && !chunk_offloaded && !writeback.wrote(piece_offset, bytes_to_write)) {
+                return EXIT_WRITE_FAILED;
+            }
+            stats.total_erased += bytes_to_write;
+            piece_offset += bytes_to_write;
+        }
+
+        const unsigned long long processed_bytes = std::min<unsigned long long>(offset + erase_size + skip_size, device_size);
+        report_erase_progress(options, start_time, processed_bytes, stats, device_size);
+        if (options.progress != nullptr) {
+            options.progress->completed_offset.store(processed_bytes, std::memory_order_release);
+        }
+
+        if (options.simulate) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> total_time = end_time - start_time;
+    stats.duration_seconds = total_time.count();
+    return EXIT_OK;
+}
+
+// Osobny opis otwartego pliku dla wątku zapisującego: przełączanie O_DIRECT przy ogonie
+// i okno zapisu zwrotnego jednego wątku nie wpływają na pozostałe
+int reopen_target(int fd) {
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags < 0) {
+        return -1;
+    }
+    const std::string path = "/proc/self/fd/" + std::to_string(fd);
+    return open(path.c_str(), flags & (O_ACCMODE | O_DIRECT | O_SYNC | O_DSYNC));
+}
+
+// --writers N: fragmenty erase/skip dzielone między wątki, każdy z własnym deskryptorem i pwritev;
+// interleaved wydaje kolejne fragmenty ze wspólnego licznika, contiguous daje każdemu wątkowi ciągły zakres
+int erase_target_writers(
+    int fd,
+    unsigned long long device_size,
+    size_t erase_size,
+    size_t skip_size,
+    const EraseOptions& options,
+    EraseStats& stats
+) {
+    const unsigned writers = options.writers;
+    const unsigned long long stride = static_cast<unsigned long long>(erase_size) + skip_size;
+    const unsigned long long chunk_count = (device_size + stride - 1) / stride;
+    const unsigned long long first_chunk = std::min(options.start_offset / stride, chunk_count);
+    const size_t write_size = options.io_size > 0 ? std::min(options.io_size, erase_size) : erase_size;
+
+    std::vector<int> worker_fds;
+    if (!options.simulate) {
+        for (unsigned worker_index = 0; worker_index < writers; ++worker_index) {
+            const int worker_fd = reopen_target(fd);
+            if (worker_fd < 0) {
+                perror("Error opening device for writer thread");
+                for (int opened_fd : worker_fds) {
+                    close(opened_fd);
+                }
+                return EXIT_OPEN_FAILED;
+            }
+            worker_fds.push_back(worker_fd);
+        }
+    }
+
+    // Ciągłe zakresy: wątek w dostaje fragmenty [range_begin[w], range_begin[w + 1])
+    std::vector<unsigned long long> range_begin(writers + 1);
+    for (unsigned worker_index = 0; worker_index <= writers; ++worker_index) {
+        range_begin[worker_index] = first_chunk + (chunk_count - first_chunk) * worker_index / writers;
+    }
+
+    // Obszar zer jest tylko czytany, więc wątki dzielą jeden; każdy ma własne iovec
+    const ZeroSource zeros(options.direct_alignment);
+    std::vector<EraseStats> shard_stats(writers);
+    std::unique_ptr<std::atomic<unsigned long long>[]> current_chunk(new std::atomic<unsigned long long>[writers]);
+    for (unsigned worker_index = 0; worker_index < writers; ++worker_index) {
+        current_chunk[worker_index].store(options.layout == WriterLayout::Contiguous ? range_begin[worker_index] : first_chunk);
+    }
+    std::atomic<unsigned long long> next_chunk{first_chunk};
+    std::atomic<unsigned long long> erased_bytes{0};
+    std::atomic<unsigned long long> processed_bytes{0};
+    std::atomic<unsigned> finished_workers{0};
+    std::atomic<int> failure{EXIT_OK};
+    stats = EraseStats{};
+    stats.resumed_bytes = erased_bytes_before(options.start_offset, erase_size, skip_size);
+
+    // Pierwszy błąd zatrzymuje wszystkie wątki; tylko on jest wypisywany
+    auto fail = [&failure](int exit_code) {
+        int expected = EXIT_OK;
+        return failure.compare_exchange_strong(expected, exit_code);
+    };
+
+    auto worker = [&](unsigned worker_index) {
+        const int worker_fd = options.simulate ? -1 : worker_fds[worker_index];
+        EraseStats& local = shard_stats[worker_index];
+        WritebackWindow writeback(worker_fd, options.simulate ? 0 : options.sync_window, options.error_log);
+        std::vector<iovec> vectors;
+        unsigned long long contiguous_next = range_begin[worker_index];
+
+        while (keep_running && failure.load(std::memory_order_relaxed) == EXIT_OK) {
+            unsigned long long chunk_index = 0;
+            if (options.layout == WriterLayout::Contiguous) {
+                if (contiguous_next >= range_begin[worker_index + 1]) {
+                    break;
+                }
+                chunk_index = contiguous_next++;
+            } else {
+                chunk_index = next_chunk.fetch_add(1, std::memory_order_relaxed);
+                if (chunk_index >= chunk_count) {
+                    break;
+                }
+            }
+            current_chunk[worker_index].store(chunk_index, std::memory_order_release);
+
+            const unsigned long long offset = chunk_index * stride;
+            const unsigned long long chunk_end = std::min<unsigned long long>(offset + erase_size, device_size);
+            unsigned long long piece_offset = std::max(offset, options.start_offset);
+
+            IoBudgetSlot budget_slot(options.simulate ? nullptr : options.io_budget);
+            while (piece_offset < chunk_end && failure.load(std::memory_order_relaxed) == EXIT_OK) {
+                size_t bytes_to_write = static_cast<size_t>(chunk_end - piece_offset);
+                if (options.data_extents != nullptr) {
+                    unsigned long long hole_length = 0;
+                    unsigned long long data_length = 0;
+                    split_at_holes(*options.data_extents, piece_offset, chunk_end, hole_length, data_length);
+                    local.skipped_bytes += hole_length;
+                    erased_bytes.fetch_add(hole_length, std::memory_order_relaxed);
+                    piece_offset += hole_length;
+                    bytes_to_write = static_cast<size_t>(data_length);
+                    if (bytes_to_write == 0) {
+                        break;
+                    }
+                }
+
+                if (!options.simulate) {
+                    const size_t tail_bytes = options.direct_alignment > 0 ? bytes_to_write % options.direct_alignment : 0;
+                    const size_t aligned_bytes = bytes_to_write - tail_bytes;
+                    size_t bytes_written = 0;
+                    while (bytes_written < aligned_bytes) {
+                        size_t request_length = std::min(write_size, aligned_bytes - bytes_written);
+                        if (options.throttle != nullptr) {
+                            request_length = options.throttle->request_size(request_length);
+                            options.throttle->acquire(request_length);
+                        }
+                        const unsigned long long write_start = options.write_latency != nullptr ? monotonic_ns() : 0;
+                        zeros.fill(vectors, request_length);
+                        const ssize_t write_result = pwritev(worker_fd, vectors.data(), static_cast<int>(vectors.size()),
+                                                             static_cast<off_t>(piece_offset + bytes_written));
+                        if (write_result < 0) {
+                            const int write_error = errno;
+                            if (options.error_log != nullptr) {
+                                options.error_log->record(piece_offset + bytes_written, write_error);
+                            }
+                            if (fail(EXIT_WRITE_FAILED)) {
+                                std::cerr << "\nError writing to device at offset " << piece_offset + bytes_written << ": "
+                                          << std::strerror(write_error) << std::endl;
+                            }
+                            break;
+                        }
+                        if (options.write_latency != nullptr) {
+                            options.write_latency->record(monotonic_ns() - write_start);
+                        }
+                        if (write_result == 0) {
+                            if (fail(EXIT_WRITE_FAILED)) {
+                                std::cerr << "\nError: no data written to device." << std::endl;
+                            }
+                            break;
+                        }
+                        bytes_written += static_cast<size_t>(write_result);
+                    }
+                    if (bytes_written < aligned_bytes) {
+                        break;
+                    }
+
+                    if (tail_bytes > 0 && !write_buffered_tail(worker_fd, piece_offset + aligned_bytes, zeros.data(), tail_bytes)) {
+                        if (options.error_log != nullptr) {
+                            options.error_log->record(piece_offset + aligned_bytes, errno);
+                        }
+                        fail(EXIT_WRITE_FAILED);
+                        break;
+                    }
+                    if (!writeback.wrote(piece_offset, bytes_to_write)) {
+                        fail(EXIT_WRITE_FAILED);
+                        break;
+                    }
+                    local.written_bytes += bytes_to_write;
+                }
+
+                erased_bytes.fetch_add(bytes_to_write, std::memory_order_relaxed);
+                piece_offset += bytes_to_write;
+            }
+
+            if (failure.load(std::memory_order_relaxed) != EXIT_OK) {
+                break;
+            }
+            processed_bytes.fetch_add(std::min<unsigned long long>(offset + stride, device_size) - offset, std::memory_order_relaxed);
+            if (options.simulate) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+
+        // Wątek bez pracy nie wstrzymuje wyznaczania zakończonego prefiksu
+        if (failure.load(std::memory_order_relaxed) == EXIT_OK && keep_running) {
+            current_chunk[worker_index].store(options.layout == WriterLayout::Contiguous ? range_begin[worker_index + 1] : chunk_count,
+                                              std::memory_order_release);
+        }
+        finished_workers.fetch_add(1, std::memory_order_release);
+    };
+
+    // Zakończony prefiks: przy interleaved wszystko poniżej najmniejszego bieżącego fragmentu (fragmenty są wydawane rosnąco),
+    // przy contiguous zakresy kolejnych wątków, dopóki poprzedni jest skończony
+    auto completed_chunks = [&]() {
+        unsigned long long prefix = options.layout == WriterLayout::Contiguous ? first_chunk
+                                                                               : next_chunk.load(std::memory_order_acquire);
+        for (unsigned worker_index = 0; worker_index < writers; ++worker_index) {
+            const unsigned long long position = current_chunk[worker_index].load(std::memory_order_acquire);
+            if (options.layout != WriterLayout::Contiguous) {
+                prefix = std::min(prefix, position);
+                continue;
+            }
+            prefix = position;
+            if (position < range_begin[worker_index + 1]) {
+                break;
+            }
+        }
+        return prefix;
+    };
+
+    const unsigned long long base_processed = first_chunk * stride;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto publish = [&]() {
+        EraseStats snapshot;
+        snapshot.resumed_bytes = stats.resumed_bytes;
+        snapshot.total_erased = stats.resumed_bytes + erased_bytes.load(std::memory_order_relaxed);
+        const unsigned long long processed = std::min(base_processed + processed_bytes.load(std::memory_order_relaxed), device_size);
+        report_erase_progress(options, start_time, processed, snapshot, device_size);
+        if (options.progress != nullptr) {
+            const unsigned long long completed = std::min(completed_chunks() * stride, device_size);
+            options.progress->completed_offset.store(std::max(completed, options.start_offset), std::memory_order_release);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned worker_index = 0; worker_index < writers; ++worker_index) {
+        workers.emplace_back(worker, worker_index);
+    }
+    while (finished_workers.load(std::memory_order_acquire) < writers) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        publish();
+    }
+    for (std::thread& worker_thread : workers) {
+        worker_thread.join();
+    }
+    publish();
+    for (int worker_fd : worker_fds) {
+        close(worker_fd);
+    }
+
+    for (const EraseStats& part : shard_stats) {
+        stats.written_bytes += part.written_bytes;
+        stats.skipped_bytes += part.skipped_bytes;
+    }
+    stats.total_erased = stats.resumed_bytes + erased_bytes.load();
+    stats.duration_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+    return failure.load();
+}
+
+// Minimalna obsługa io_uring bez liburing (bezpośrednie wywołania systemowe)
+struct IoUringQueue {
+    int ring_fd = -1;
+    void* sq_ring = nullptr;
+    size_t sq_ring_size = 0;
+    void* cq_ring = nullptr;
+    size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqes_size = 0;
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned pending_submit = 0;
+
+    IoUringQueue() = default;
+    IoUringQueue(const IoUringQueue&) = delete;
+    IoUringQueue& operator=(const IoUringQueue&) = delete;
+
+    ~IoUringQueue() {
+        if (sqes != nullptr) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ring != nullptr && cq_ring != sq_ring) {
+            munmap(cq_ring, cq_ring_size);
+        }
+        if (sq_ring != nullptr) {
+            munmap(sq_ring, sq_ring_size);
+        }
+        if (ring_fd >= 0) {
+            close(ring_fd);
+        }
+    }
+
+    bool setup(unsigned entries, std::string& error) {
+        io_uring_params params {};
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd < 0) {
+            error = std::string("io_uring setup failed: ") + std::strerror(errno) + ".";
+            return false;
+        }
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED) {
+            sq_ring = nullptr;
+            error = std::string("io_uring ring mapping failed: ") + std::strerror(errno) + ".";
+            return false;
+        }
+
+        if (single_mmap) {
+            cq_ring = sq_ring;
+        } else {
+            cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) {
+                cq_ring = nullptr;
+                error = std::string("io_uring completion ring mapping failed: ") + std::strerror(errno) + ".";
+                return false;
+            }
+        }
+
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes_memory = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sqes_memory == MAP_FAILED) {
+            error = std::string("io_uring submission entries mapping failed: ") + std::strerror(errno) + ".";
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqes_memory);
+
+        char* sq_base = static_cast<char*>(sq_ring);
+        sq_head = reinterpret_cast<unsigned*>(sq_base + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned*>(sq_base + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq_base + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq_base + params.sq_off.array);
+
+        char* cq_base = static_cast<char*>(cq_ring);
+        cq_head = reinterpret_cast<unsigned*>(cq_base + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq_base + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq_base + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq_base + params.cq_off.cqes);
+        return true;
+    }
+
+    // Czy jądro obsługuje dane operacje (IORING_REGISTER_PROBE, od 5.6); jądra 5.1–5.5 nie mają ani sondy,
+    // ani IORING_OP_WRITE, więc nieudana sonda też oznacza brak wsparcia
+    bool supports_opcodes(std::initializer_list<unsigned> opcodes, std::string& error) {
+        constexpr unsigned probe_ops = 256;
+        std::vector<unsigned char> memory(sizeof(io_uring_probe) + probe_ops * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(memory.data());
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, probe_ops) < 0) {
+            error = std::string("io_uring opcode probe failed: ") + std::strerror(errno) + ".";
+            return false;
+        }
+
+        for (unsigned opcode : opcodes) {
+            if (opcode > probe->last_op || (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) == 0) {
+                error = "io_uring does not support opcode " + std::to_string(opcode) + " on this kernel.";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Wywołujący pilnuje, by liczba zleceń w locie nie przekraczała rozmiaru kolejki
+    io_uring_sqe* next_sqe() {
+        const unsigned tail = *sq_tail;
+        const unsigned index = tail & *sq_mask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        ++pending_submit;
+        return sqe;
+    }
+
+    bool submit_and_wait(unsigned wait_count, std::string& error) {
+        while (true) {
+            const long result = syscall(__NR_io_uring_enter, ring_fd, pending_submit, wait_count,
+                                        wait_count > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (result >= 0) {
+                pending_submit -= std::min<unsigned>(pending_submit, static_cast<unsigned>(result));
+                return true;
+            }
+
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                error = std::string("io_uring submission failed: ") + std::strerror(errno) + ".";
+                return false;
+            }
+        }
+    }
+
+    bool pop_completion(io_uring_cqe& completion) {
+        const unsigned head = *cq_head;
+        if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+
+        completion = cqes[head & *cq_mask];
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+
+int erase_target_io_uring(
+    int fd,
+    unsigned long long device_size,
+    size_t erase_size,
+    size_t skip_size,
+    const EraseOptions& options,
+    EraseStats& stats
+) {
+    constexpr size_t io_uring_request_size = 4 * 1024 * 1024;
+
+    struct PendingWrite {
+        unsigned long long offset = 0;
+        size_t length = 0;
+        const unsigned char* data = nullptr;
+        unsigned long long submit_ns = 0;
+        bool active = false;
+    };
+
+    // Wszystkie zlecenia zapisują zera z tego samego obszaru 1 MB (większe jako IORING_OP_WRITEV)
+    const size_t request_size = std::min(erase_size, options.io_size > 0 ? options.io_size : io_uring_request_size);
+    ZeroSource zeros(options.direct_alignment);
+    WritebackWindow writeback(fd, options.sync_window, options.error_log);
+    std::vector<PendingWrite> slots(options.queue_depth);
+    std::vector<std::vector<iovec>> slot_vectors(options.queue_depth);
+    std::vector<unsigned> free_slots;
+    for (unsigned slot = options.queue_depth; slot > 0; --slot) {
+        free_slots.push_back(slot - 1);
+    }
+
+    IoUringQueue ring;
+    std::string ring_error;
+    if (!ring.setup(options.queue_depth, ring_error) || !ring.supports_opcodes({IORING_OP_WRITE, IORING_OP_WRITEV}, ring_error)) {
+        std::cerr << "Warning: " << ring_error << " Falling back to sync engine." << std::endl;
+        return erase_target_sync(fd, device_size, erase_size, skip_size, options, stats);
+    }
+
+    auto queue_write = [&](unsigned slot) {
+        io_uring_sqe* sqe = ring.next_sqe();
+        sqe->fd = fd;
+        sqe->off = slots[slot].offset;
+        if (options.feed != nullptr || slots[slot].length <= ZeroSource::region_size) {
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->addr = reinterpret_cast<unsigned long long>(slots[slot].data);
+            sqe->len = static_cast<unsigned>(slots[slot].length);
+        } else {
+            zeros.fill(slot_vectors[slot], slots[slot].length);
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<unsigned long long>(slot_vectors[slot].data());
+            sqe->len = static_cast<unsigned>(slot_vectors[slot].size());
+        }
+        sqe->user_data = slot;
+        if (options.write_latency != nullptr) {
+            slots[slot].submit_ns = monotonic_ns();
+        }
+    };
+
+    const unsigned long long stride = static_cast<unsigned long long>(erase_size) + skip_size;
+    unsigned long long chunk_offset = options.start_offset - options.start_offset % stride;
+    unsigned long long chunk_position = options.start_offset % stride;
+    PendingWrite unaligned_tail;
+    auto next_request = [&](PendingWrite& request) {
+        while (chunk_offset < device_size) {
+            unsigned long long chunk_length = std::min<unsigned long long>(erase_size, device_size - chunk_offset);
+            if (options.direct_alignment > 0 && chunk_length % options.direct_alignment != 0) {
+                // Nierówny ogon ostatniego fragmentu dopisujemy po opróżnieniu kolejki
+                const size_t tail_bytes = static_cast<size_t>(chunk_length % options.direct_alignment);
+                chunk_length -= tail_bytes;
+                unaligned_tail.offset = chunk_offset + chunk_length;
+                unaligned_tail.length = tail_bytes;
+            }
+
+            if (chunk_position < chunk_length && options.data_extents != nullptr) {
+                // Zakresy spoza data_extents pomijamy, licząc je jako już wyzerowane
+                unsigned long long hole_length = 0;
+                unsigned long long data_length = 0;
+                split_at_holes(*options.data_extents, chunk_offset + chunk_position, chunk_offset + chunk_length,
+                               hole_length, data_length);
+                stats.skipped_bytes += hole_length;
+                stats.total_erased += hole_length;
+                chunk_position += hole_length;
+            }
+
+            if (chunk_position < chunk_length) {
+                request.offset = chunk_offset + chunk_position;
+                const size_t paced_size = options.throttle != nullptr ? options.throttle->request_size(request_size) : request_size;
+                request.length = static_cast<size_t>(std::min<unsigned long long>(paced_size, chunk_length - chunk_position));
+                if (options.feed != nullptr) {
+                    // Dane wzorca pochodzą z jednego okna generatora, więc zlecenie nie może przekroczyć jego granicy
+                    const unsigned long long window_end = (request.offset / PatternFeed::window_size + 1) * PatternFeed::window_size;
+                    request.length = static_cast<size_t>(std::min<unsigned long long>(request.length, window_end - request.offset));
+                }
+                if (options.data_extents != nullptr) {
+                    unsigned long long hole_length = 0;
+                    unsigned long long data_length = 0;
+                    split_at_holes(*options.data_extents, request.offset, request.offset + request.length, hole_length, data_length);
+                    request.length = static_cast<size_t>(data_length);
+                }
+                chunk_position += request.length;
+                return true;
+            }
+
+            chunk_offset += static_cast<unsigned long long>(erase_size) + skip_size;
+            chunk_position = 0;
+        }
+        return false;
+    };
+
+    stats = EraseStats{};
+    stats.resumed_bytes = erased_bytes_before(options.start_offset, erase_size, skip_size);
+    stats.total_erased = stats.resumed_bytes;
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    unsigned in_flight = 0;
+    PendingWrite pending_request;
+    bool has_pending_request = false;
+    int failure_errno = 0;
+    bool failed = false;
+    bool failure_reported = false;
+    bool zero_write = false;
+
+    while (true) {
+        while (!failed && keep_running && !free_slots.empty()) {
+            PendingWrite request;
+            if (has_pending_request) {
+                request = pending_request;
+                has_pending_request = false;
+            } else if (!next_request(request)) {
+                break;
+            }
+
+            // Bez wolnego slotu budżetu czekamy na własne zakończenia, a gdy nic nie jest w locie – na innych
+            if (options.io_budget != nullptr && !options.io_budget->try_acquire()) {
+                if (in_flight > 0) {
+                    pending_request = request;
+                    has_pending_request = true;
+                    break;
+                }
+                options.io_budget->acquire();
+            }
+
+            if (options.throttle != nullptr) {
+                options.throttle->acquire(request.length);
+            }
+            const unsigned slot = free_slots.back();
+            free_slots.pop_back();
+            slots[slot] = request;
+            slots[slot].data = options.feed != nullptr ? options.feed->acquire(request.offset) : zeros.region.data;
+            slots[slot].active = true;
+            queue_write(slot);
+            ++in_flight;
+
+            // Przy limicie każde zlecenie trafia do jądra w swoim terminie, a nie w paczce z kolejnymi
+            if (options.throttle != nullptr && options.throttle->active() && !ring.submit_and_wait(0, ring_error)) {
+                break;
+            }
+        }
+
+        if (in_flight == 0) {
+            break;
+        }
+
+        if (!ring.submit_and_wait(1, ring_error)) {
+            std::cerr << "Error: " << ring_error << std::endl;
+            for (unsigned index = 0; options.io_budget != nullptr && index < in_flight; ++index) {
+                options.io_budget->release();
+            }
+            return EXIT_WRITE_FAILED;
+        }
+
+        io_uring_cqe completion {};
+        while (ring.pop_completion(completion)) {
+            const unsigned slot = static_cast<unsigned>(completion.user_data);
+            --in_flight;
+            if (options.write_latency != nullptr) {
+                options.write_latency->record(monotonic_ns() - slots[slot].submit_ns);
+            }
+
+            if (completion.res <= 0) {
+                if (!failed) {
+                    failed = true;
+                    zero_write = completion.res == 0;
+                    failure_errno = -completion.res;
+                }
+                if (options.error_log != nullptr && completion.res < 0) {
+                    options.error_log->record(slots[slot].offset, -completion.res);
+                }
+                slots[slot].active = false;
+                free_slots.push_back(slot);
+                if (options.feed != nullptr) {
+                    options.feed->release(slots[slot].offset);
+                }
+                if (options.io_budget != nullptr) {
+                    options.io_budget->release();
+                }
+                continue;
+            }
+
+            const size_t written = static_cast<size_t>(completion.res);
+            stats.total_erased += written;
+            stats.written_bytes += written;
+            if (!writeback.wrote(slots[slot].offset, written) && !failed) {
+                failed = true;
+                failure_reported = true;
+            }
+
+            if (written < slots[slot].length && !failed) {
+                slots[slot].offset += written;
+                slots[slot].length -= written;
+                // Dane wzorca przesuwają się razem z offsetem, zera zawsze zaczynają się od początku obszaru
+                slots[slot].data = options.feed != nullptr ? slots[slot].data + written : zeros.region.data;
+                queue_write(slot);
+                ++in_flight;
+                continue;
+            }
+
+            slots[slot].active = false;
+            free_slots.push_back(slot);
+            if (options.feed != nullptr) {
+                options.feed->release(slots[slot].offset);
+            }
+            if (options.io_budget != nullptr) {
+                options.io_budget->release();
+            }
+        }
+
+        // Zakończenia przychodzą w dowolnej kolejności: gotowy jest tylko prefiks przed najniższym zleceniem w locie
+        if (options.progress != nullptr && !failed) {
+            unsigned long long completed = has_pending_request ? pending_request.offset : chunk_offset + chunk_position;
+            for (const PendingWrite& pending : slots) {
+                if (pending.active) {
+                    completed = std::min(completed, pending.offset);
+                }
+            }
+            if (unaligned_tail.length > 0) {
+                completed = std::min(completed, unaligned_tail.offset);
+            }
+            options.progress->completed_offset.store(std::min(completed, device_size), std::memory_order_release);
+        }
+
+        report_erase_progress(options, start_time, processed_bytes_for_erased(stats.total_erased, erase_size, skip_size, device_size),
+                              stats, device_size);
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> total_time = end_time - start_time;
+    stats.duration_seconds = total_time.count();
+
+    if (failed) {
+        if (zero_write) {
+            std::cerr << "Error: no data written to device." << std::endl;
+        } else if (!failure_reported) {
+            errno = failure_errno;
+            perror("Error writing to device");
+        }
+        return EXIT_WRITE_FAILED;
+    }
+
+    if (unaligned_tail.length > 0 && keep_running) {
+        unsigned long long hole_length = 0;
+        unsigned long long data_length = unaligned_tail.length;
+        if (options.data_extents != nullptr) {
+            split_at_holes(*options.data_extents, unaligned_tail.offset, unaligned_tail.offset + unaligned_tail.length,
+                           hole_length, data_length);
+        }
+
+        if (data_length > 0) {
+            const unsigned char* tail_data = options.feed != nullptr ? options.feed->acquire(unaligned_tail.offset) : zeros.region.data;
+            const bool tail_written = write_buffered_tail(fd, unaligned_tail.offset, reinterpret_cast<const char*>(tail_data),
+                                                          unaligned_tail.length);
+            if (options.feed != nullptr) {
+                options.feed->release(unaligned_tail.offset);
+            }
+            if (!tail_written) {
+                if (options.error_log != nullptr) {
+                    options.error_log->record(unaligned_tail.offset, errno);
+                }
+                return EXIT_WRITE_FAILED;
+            }
+            stats.written_bytes += unaligned_tail.length;
+        } else {
+            stats.skipped_bytes += unaligned_tail.length;
+        }
+        stats.total_erased += unaligned_tail.length;
+        if (options.progress != nullptr) {
+            options.progress->completed_offset.store(device_size, std::memory_order_release);
+        }
+        stats.duration_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+    }
+
+    return EXIT_OK;
+}
+
+// Kasowanie tylko brudnych fragmentów: potok czyta zakresy z wyprzedzeniem, a zera trafiają
+// jedynie tam, gdzie skan znalazł bajty !00 (czyste fragmenty nie zużywają zapisów SSD)
+int erase_target_skip_clean(
+    int fd,
+    unsigned long long device_size,
+    size_t erase_size,
+    size_t skip_size,
+    const EraseOptions& options,
+    EraseStats& stats
+) {
+    struct stat target_stat {};
+    const bool block_device = fstat(fd, &target_stat) == 0 && S_ISBLK(target_stat.st_mode);
+    bool offload_available = options.offload != OffloadMode::None && !options.simulate;
+    bool offload_rejected = false;
+
+    size_t scan_chunk_size = options.scan_chunk_size;
+    if (options.direct_alignment > 0 && scan_chunk_size % options.direct_alignment != 0) {
+        scan_chunk_size += options.direct_alignment - scan_chunk_size % options.direct_alignment;
+    }
+    std::unique_ptr<ZeroSource> zeros;
+    WritebackWindow writeback(fd, options.simulate ? 0 : options.sync_window, options.error_log);
+
+    const unsigned long long stride = static_cast<unsigned long long>(erase_size) + skip_size;
+    stats = EraseStats{};
+    stats.resumed_bytes = erased_bytes_before(options.start_offset, erase_size, skip_size);
+    stats.total_erased = stats.resumed_bytes;
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    // Zakresy do odczytu: wzór erase/skip od punktu wznowienia, tylko data_extents, najwyżej scan_chunk_size naraz
+    unsigned long long cursor = options.start_offset;
+    ReadAheadPipeline pipeline(fd, scan_chunk_size, options.scan_buffers, options.direct_alignment,
+        [&](unsigned long long& range_offset, size_t& range_length) {
+            cursor = next_erased_position(cursor, device_size, erase_size, skip_size, options);
+            if (cursor >= device_size || !keep_running) {
+                return false;
+            }
+
+            unsigned long long end = std::min({cursor - cursor % stride + erase_size, device_size,
+                                               cursor + static_cast<unsigned long long>(scan_chunk_size)});
+            if (options.data_extents != nullptr) {
+                unsigned long long hole_length = 0;
+                unsigned long long data_length = 0;
+                split_at_holes(*options.data_extents, cursor, end, hole_length, data_length);
+                end = cursor + hole_length + data_length;
+            }
+            range_offset = cursor;
+            range_length = static_cast<size_t>(end - cursor);
+            cursor = end;
+            return true;
+        }, options.read_latency, options.throttle);
+
+    const ZeroScanner& scanner = active_zero_scanner();
+    ReadAheadPipeline::Chunk chunk;
+    while (keep_running && pipeline.next(chunk)) {
+        if (chunk.read_result < 0 || static_cast<size_t>(chunk.read_result) < chunk.length) {
+            if (options.error_log != nullptr) {
+                options.error_log->record(chunk.offset, chunk.error != 0 ? chunk.error : EIO);
+            }
+            std::cerr << "\nError: could not read device at offset " << chunk.offset << " bytes." << std::endl;
+            return EXIT_WRITE_FAILED;
+        }
+
+        const ZeroScanResult scan = scanner.scan(chunk.data, chunk.length, true);
+        stats.scanned_bytes += chunk.length;
+        if (scan.first_non_zero == ZeroScanResult::npos) {
+            stats.clean_bytes += chunk.length;
+        } else if (!options.simulate) {
+            IoBudgetSlot budget_slot(options.io_budget);
+            bool chunk_offloaded = false;
+            if (offload_available) {
+                if (options.throttle != nullptr) {
+                    options.throttle->acquire(chunk.length);
+                }
+                const unsigned long long offload_start = monotonic_ns();
+                const OffloadResult offload_result = offload_zero_range(fd, options.offload, block_device, chunk.offset, chunk.length);
+                if (options.write_latency != nullptr && offload_result == OffloadResult::Done) {
+                    options.write_latency->record(monotonic_ns() - offload_start);
+                }
+                if (offload_result == OffloadResult::Failed) {
+                    if (options.error_log != nullptr) {
+                        options.error_log->record(chunk.offset, errno);
+                    }
+                    perror("Error zeroing range on device");
+                    return EXIT_WRITE_FAILED;
+                }
+
+                if (offload_result == OffloadResult::Done) {
+                    stats.offloaded_bytes += chunk.length;
+                    chunk_offloaded = true;
+                } else if (offload_result == OffloadResult::Unsupported) {
+                    std::cerr << "\nWarning: " << offload_mode_name(options.offload, block_device)
+                              << " is not supported by target (" << std::strerror(errno) << "), falling back to writes." << std::endl;
+                    offload_available = false;
+                } else if (!offload_rejected) {
+                    std::cerr << "\nWarning: " << offload_mode_name(options.offload, block_device)
+                              << " rejected a range (" << std::strerror(errno) << "), writing such chunks instead." << std::endl;
+                    offload_rejected = true;
+                }
+            }
+
+            if (!chunk_offloaded) {
+                if (zeros == nullptr) {
+                    zeros.reset(new ZeroSource(options.direct_alignment));
+                }
+
+                const size_t tail_bytes = options.direct_alignment > 0 ? chunk.length % options.direct_alignment : 0;
+                const size_t aligned_bytes = chunk.length - tail_bytes;
+                size_t bytes_written = 0;
+                while (bytes_written < aligned_bytes) {
+                    size_t request_length = aligned_bytes - bytes_written;
+                    if (options.throttle != nullptr) {
+                        request_length = options.throttle->request_size(request_length);
+                        options.throttle->acquire(request_length);
+                    }
+                    const unsigned long long write_start = options.write_latency != nullptr ? monotonic_ns() : 0;
+                    zeros->prepare(request_length);
+                    const ssize_t write_result = pwritev(fd, zeros->vectors.data(), static_cast<int>(zeros->vectors.size()),
+                                                         static_cast<off_t>(chunk.offset + bytes_written));
+                    if (write_result < 0) {
+                        if (options.error_log != nullptr) {
+                            options.error_log->record(chunk.offset + bytes_written, errno);
+                        }
+                        perror("Error writing to device");
+                        return EXIT_WRITE_FAILED;
+                    }
+                    if (options.write_latency != nullptr) {
+                        options.write_latency->record(monotonic_ns() - write_start);
+                    }
+
+                    if (write_result == 0) {
+                        std::cerr << "Error: no data written to device." << std::endl;
+                        return EXIT_WRITE_FAILED;
+                    }
+
+                    bytes_written += static_cast<size_t>(write_result);
+                }
+
+                if (tail_bytes > 0 && !write_buffered_tail(fd, chunk.offset + aligned_bytes, zeros->data(), tail_bytes)) {
+                    if (options.error_log != nullptr) {
+                        options.error_log->record(chunk.offset + aligned_bytes, errno);
+                    }
+                    return EXIT_WRITE_FAILED;
+                }
+                stats.written_bytes += chunk.length;
+                if (!writeback.wrote(chunk.offset, chunk.length)) {
+                    return EXIT_WRITE_FAILED;
+                }
+            }
+        }
+
+        // Wszystko przed końcem fragmentu jest już zerowe: przeczytane, zapisane albo pominięte jako dziura
+        const unsigned long long chunk_end = chunk.offset + chunk.length;
+        pipeline.release();
+        stats.total_erased = erased_bytes_before(chunk_end, erase_size, skip_size);
+        stats.skipped_bytes = stats.total_erased - stats.resumed_bytes - stats.scanned_bytes;
+        report_erase_progress(options, start_time, chunk_end, stats, device_size);
+        if (options.progress != nullptr) {
+            options.progress->completed_offset.store(chunk_end, std::memory_order_release);
+        }
+    }
+
+    if (keep_running) {
+        stats.total_erased = erased_bytes_before(device_size, erase_size, skip_size);
+        stats.skipped_bytes = stats.total_erased - stats.resumed_bytes - stats.scanned_bytes;
+        report_erase_progress(options, start_time, device_size, stats, device_size);
+        if (options.progress != nullptr) {
+            options.progress->completed_offset.store(device_size, std::memory_order_release);
+        }
+    }
+
+    stats.duration_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+    return EXIT_OK;
+}
+
+int erase_target(
+    int fd,
+    unsigned long long device_size,
+    size_t erase_size,
+    size_t skip_size,
+    const EraseOptions& options,
+    EraseStats& stats
+) {
+    // Mapa dziur jest zbierana przed zapisem; zapisy trafiają tylko w zakresy z danymi, więc dziury pozostają dziurami
+    EraseOptions target_options = options;
+    std::vector<DataExtent> data_extents;
+    if (options.skip_holes && options.data_extents == nullptr) {
+        if (map_data_extents(fd, device_size, data_extents)) {
+            target_options.data_extents = &data_extents;
+        } else {
+            std::cerr << "Warning: target is not a sparse-capable regular file, --skip-holes ignored." << std::endl;
+        }
+    }
+
+    // Przebieg z wzorcem innym niż zera zapisuje dane z generatora (offload potrafi tylko zerować)
+    std::unique_ptr<PatternFeed> feed;
+    if (options.pattern != nullptr && options.pattern->kind != PatternKind::Zero) {
+        target_options.offload = OffloadMode::None;
+        if (!options.simulate) {
+            const bool uses_ring = target_options.engine == EraseEngine::IoUring;
+            const size_t window_count = (uses_ring ? target_options.queue_depth : 1) + 2 * options.generator_threads + 2;
+            feed.reset(new PatternFeed(*options.pattern, device_size,
+                [&](unsigned long long position) {
+                    return next_erased_position(position, device_size, erase_size, skip_size, target_options);
+                },
+                window_count, options.generator_threads, options.direct_alignment));
+            target_options.feed = feed.get();
+        }
+    }
+
+    int result = EXIT_OK;
+    if (target_options.skip_clean) {
+        result = erase_target_skip_clean(fd, device_size, erase_size, skip_size, target_options, stats);
+    } else if (target_options.engine == EraseEngine::IoUring && !target_options.simulate) {
+        result = erase_target_io_uring(fd, device_size, erase_size, skip_size, target_options, stats);
+    } else if (target_options.writers > 1) {
+        result = erase_target_writers(fd, device_size, erase_size, skip_size, target_options, stats);
+    } else {
+        result = erase_target_sync(fd, device_size, erase_size, skip_size, target_options, stats);
+    }
+
+    // Zakończenie (także przerwane) jest zgłaszane dopiero, gdy zapisane dane są na nośniku, a nie w cache stron
+    if (result == EXIT_OK && !options.simulate) {
+        result = sync_erased_target(fd, options, stats);
+    }
+    return result;
+}
+
+// Obszar metadanych (tablica partycji, superblok, nagłówek LUKS/LVM) zerowany przed właściwym przebiegiem (--metadata-first)
+struct MetadataRegion {
+    unsigned long long offset = 0;
+    unsigned long long length = 0;
+    std::string description;
+};
+
+uint64_t load_le(const unsigned char* data, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t index = bytes; index-- > 0;) {
+        value = (value << 8) | data[index];
+    }
+    return value;
+}
+
+uint64_t load_be(const unsigned char* data, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t index = 0; index < bytes; ++index) {
+        value = (value << 8) | data[index];
+    }
+    return value;
+}
+
+// Wykrywanie struktur, których zniszczenie najszybciej czyni dane bezużytecznymi; odczyty idą przez osobny deskryptor bez O_DIRECT
+struct MetadataScanner {
+    static constexpr unsigned long long head_region = 1024 * 1024;
+    static constexpr size_t volume_probe_size = 72 * 1024;
+    static constexpr size_t max_backups = 64;
+
+    int fd;
+    unsigned long long device_size;
+    size_t sector_size = 512;
+    std::vector<MetadataRegion> regions;
+    std::vector<unsigned char> buffer;
+
+    MetadataScanner(int target_fd, unsigned long long size) : fd(target_fd), device_size(size) {
+        int logical_sector = 0;
+        if (ioctl(fd, BLKSSZGET, &logical_sector) == 0 && logical_sector > 0) {
+            sector_size = static_cast<size_t>(logical_sector);
+        }
+    }
+
+    void add(unsigned long long offset, unsigned long long length, const std::string& description) {
+        if (offset >= device_size || length == 0) {
+            return;
+        }
+        regions.push_back(MetadataRegion{offset, std::min(length, device_size - offset), description});
+    }
+
+    // Bajty poza końcem celu są traktowane jak zera, więc sygnatury przy końcu nie dają fałszywych trafień
+    bool read(unsigned long long offset, size_t length) {
+        buffer.assign(length, 0);
+        size_t bytes_read = 0;
+        while (bytes_read < length && offset + bytes_read < device_size) {
+            const ssize_t read_result = pread(fd, buffer.data() + bytes_read, length - bytes_read,
+                                              static_cast<off_t>(offset + bytes_read));
+            if (read_result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read_result <= 0) {
+                return read_result == 0;
+            }
+            bytes_read += static_cast<size_t>(read_result);
+        }
+        return true;
+    }
+
+    // Systemy plików i kontenery na początku wolumenu (partycji albo całego celu) wraz z kopiami zapasowymi superbloków
+    void scan_volume(unsigned long long start, unsigned long long length, const std::string& where) {
+        if (!read(start, volume_probe_size)) {
+            add(start, head_region, "start of " + where + " (unreadable)");
+            return;
+        }
+        const std::vector<unsigned char> head = buffer;
+        const unsigned char* data = head.data();
+        const std::string suffix = " (" + where + ")";
+
+        if (std::memcmp(data, "LUKS\xba\xbe", 6) == 0) {
+            if (load_be(data + 6, 2) == 1) {
+                const unsigned long long payload = load_be(data + 104, 4) * 512ULL;
+                add(start, payload > 0 ? std::min<unsigned long long>(payload, 32ULL << 20) : 2ULL << 20, "LUKS1 header and key slots" + suffix);
+            } else {
+                // Domyślny obszar metadanych LUKS2: dwa nagłówki JSON i sloty kluczy w pierwszych 16 MB
+                add(start, 16ULL << 20, "LUKS2 headers and key slots" + suffix);
+            }
+            return;
+        }
+
+        for (size_t sector = 0; sector < 4; ++sector) {
+            if (std::memcmp(data + sector * 512, "LABELONE", 8) == 0) {
+                add(start, head_region, "LVM2 PV label and metadata area" + suffix);
+                return;
+            }
+        }
+
+        if (load_le(data + 1024 + 56, 2) == 0xEF53) {
+            add(start, head_region, "ext2/3/4 superblock and group descriptors" + suffix);
+            const unsigned char* super = data + 1024;
+            const uint64_t log_block_size = load_le(super + 24, 4);
+            const uint64_t first_data_block = load_le(super + 20, 4);
+            const uint64_t blocks_per_group = load_le(super + 32, 4);
+            uint64_t blocks = load_le(super + 4, 4);
+            if ((load_le(super + 0x60, 4) & 0x80) != 0) {
+                blocks |= load_le(super + 0x150, 4) << 32;
+            }
+            const bool sparse_super = (load_le(super + 0x64, 4) & 0x1) != 0;
+            if (log_block_size <= 6 && blocks_per_group > 0 && blocks > first_data_block) {
+                const unsigned long long block_size = 1024ULL << log_block_size;
+                const unsigned long long groups = (blocks - first_data_block + blocks_per_group - 1) / blocks_per_group;
+                std::vector<unsigned long long> backup_groups;
+                if (sparse_super) {
+                    backup_groups.push_back(1);
+                    for (unsigned long long base : {3ULL, 5ULL, 7ULL}) {
+                        for (unsigned long long group = base; group < groups; group *= base) {
+                            backup_groups.push_back(group);
+                        }
+                    }
+                } else {
+                    for (unsigned long long group = 1; group < groups; ++group) {
+                        backup_groups.push_back(group);
+                    }
+                }
+                std::sort(backup_groups.begin(), backup_groups.end());
+                for (size_t index = 0; index < backup_groups.size() && index < max_backups; ++index) {
+                    const unsigned long long group = backup_groups[index];
+                    const unsigned long long offset = (group * blocks_per_group + first_data_block) * block_size;
+                    if (group < groups && offset < length) {
+                        add(start + offset, std::min<unsigned long long>(64 * 1024, blocks_per_group * block_size),
+                            "ext2/3/4 backup superblock, group " + std::to_string(group) + suffix);
+                    }
+                }
+            }
+            return;
+        }
+
+        if (std::memcmp(data, "XFSB", 4) == 0) {
+            add(start, head_region, "XFS superblock and AG 0 headers" + suffix);
+            const unsigned long long block_size = load_be(data + 4, 4);
+            const unsigned long long ag_blocks = load_be(data + 84, 4);
+            const unsigned long long ag_count = load_be(data + 88, 4);
+            for (unsigned long long ag = 1; ag < ag_count && ag <= max_backups; ++ag) {
+                const unsigned long long offset = ag * ag_blocks * block_size;
+                if (offset < length) {
+                    add(start + offset, 64 * 1024, "XFS AG " + std::to_string(ag) + " headers" + suffix);
+                }
+            }
+            return;
+        }
+
+        if (std::memcmp(data + 65536 + 64, "_BHRfS_M", 8) == 0) {
+            add(start, head_region, "btrfs superblock" + suffix);
+            for (unsigned long long mirror : {64ULL << 20, 256ULL << 30, 1ULL << 50}) {
+                if (mirror + 4096 <= length) {
+                    add(start + mirror, 4096, "btrfs superblock mirror" + suffix);
+                }
+            }
+            return;
+        }
+
+        if (std::memcmp(data + 3, "NTFS    ", 8) == 0) {
+            add(start, 64 * 1024, "NTFS boot sector" + suffix);
+            const unsigned long long sector = load_le(data + 11, 2);
+            const unsigned int sectors_per_cluster = data[13];
+            const unsigned long long cluster = sectors_per_cluster > 128 ? 1ULL << (256 - sectors_per_cluster)
+                                                                          : sector * sectors_per_cluster;
+            const unsigned long long volume_sectors = load_le(data + 40, 8);
+            const unsigned long long mft = load_le(data + 48, 8) * cluster;
+            const unsigned long long mft_mirror = load_le(data + 56, 8) * cluster;
+            if (sector > 0 && volume_sectors * sector < length) {
+                add(start + volume_sectors * sector, sector, "NTFS backup boot sector" + suffix);
+            }
+            if (cluster > 0 && mft < length) {
+                add(start + mft, head_region, "NTFS $MFT (first records)" + suffix);
+            }
+            if (cluster > 0 && mft_mirror < length) {
+                add(start + mft_mirror, 64 * 1024, "NTFS $MFTMirr" + suffix);
+            }
+            return;
+        }
+
+        if (std::memcmp(data + 82, "FAT32", 5) == 0 || std::memcmp(data + 54, "FAT1", 4) == 0) {
+            const unsigned long long sector = load_le(data + 11, 2);
+            const unsigned long long reserved = load_le(data + 14, 2);
+            const unsigned long long fat_size = load_le(data + 22, 2) != 0 ? load_le(data + 22, 2) : load_le(data + 36, 4);
+            const unsigned long long fat_end = (reserved + data[16] * fat_size) * sector;
+            add(start, std::min(std::max(fat_end, head_region), 64ULL << 20), "FAT boot sector and allocation tables" + suffix);
+            return;
+        }
+
+        if (std::memcmp(data + 4086, "SWAPSPACE2", 10) == 0 || std::memcmp(data + 4086, "SWAP-SPACE", 10) == 0) {
+            add(start, head_region, "swap signature" + suffix);
+            return;
+        }
+
+        // Nieznana zawartość: początek wolumenu i tak jest najczęstszym miejscem nagłówków
+        add(start, head_region, "start of " + where + " (no known signature)");
+    }
+
+    // Nagłówek GPT (główny albo zapasowy) z tablicą partycji; partycje są przeszukiwane jak osobne wolumeny
+    bool scan_gpt(unsigned long long header_offset) {
+        if (!read(header_offset, sector_size) || std::memcmp(buffer.data(), "EFI PART", 8) != 0) {
+            return false;
+        }
+        const unsigned long long alternate = load_le(buffer.data() + 32, 8) * sector_size;
+        const unsigned long long entries = load_le(buffer.data() + 72, 8) * sector_size;
+        const unsigned long long entry_count = std::min<uint64_t>(load_le(buffer.data() + 80, 4), 1024);
+        const unsigned long long entry_size = load_le(buffer.data() + 84, 4);
+        if (entry_size < 128 || entry_size > 4096) {
+            return false;
+        }
+
+        const unsigned long long table_bytes = entry_count * entry_size;
+        const unsigned long long primary = std::min(header_offset, alternate);
+        const unsigned long long backup = std::max(header_offset, alternate);
+        add(primary, sector_size, "GPT primary header");
+        add(primary + sector_size, table_bytes, "GPT primary partition entries");
+        if (backup > table_bytes) {
+            add(backup - table_bytes, table_bytes + sector_size, "GPT backup header and partition entries");
+        }
+
+        if (!read(entries, static_cast<size_t>(table_bytes))) {
+            return true;
+        }
+        const std::vector<unsigned char> table = buffer;
+        for (unsigned long long index = 0; index < entry_count; ++index) {
+            const unsigned char* entry = table.data() + index * entry_size;
+            if (std::all_of(entry, entry + 16, [](unsigned char byte) { return byte == 0; })) {
+                continue;
+            }
+            const unsigned long long first = load_le(entry + 32, 8) * sector_size;
+            const unsigned long long last = load_le(entry + 40, 8) * sector_size;
+            if (first < last && first < device_size) {
+                scan_volume(first, std::min(last + sector_size, device_size) - first, "partition " + std::to_string(index + 1));
+            }
+        }
+        return true;
+    }
+
+    // Tablica MBR z łańcuchem partycji rozszerzonych (EBR)
+    bool scan_mbr() {
+        if (!read(0, 512) || buffer[510] != 0x55 || buffer[511] != 0xAA
+            || std::memcmp(buffer.data() + 3, "NTFS    ", 8) == 0 || std::memcmp(buffer.data() + 82, "FAT32", 5) == 0
+            || std::memcmp(buffer.data() + 54, "FAT1", 4) == 0) {
+            return false;
+        }
+
+        const std::vector<unsigned char> mbr = buffer;
+        unsigned partition_number = 0;
+        bool found = false;
+        for (size_t slot = 0; slot < 4; ++slot) {
+            const unsigned char* entry = mbr.data() + 446 + slot * 16;
+            const unsigned type = entry[4];
+            const unsigned long long first = load_le(entry + 8, 4) * sector_size;
+            const unsigned long long count = load_le(entry + 12, 4) * sector_size;
+            ++partition_number;
+            if (type == 0 || type == 0xEE || count == 0 || first >= device_size) {
+                continue;
+            }
+            found = true;
+            if (type == 0x05 || type == 0x0F || type == 0x85) {
+                scan_extended(first, partition_number);
+                continue;
+            }
+            scan_volume(first, std::min(count, device_size - first), "partition " + std::to_string(partition_number));
+        }
+        return found;
+    }
+
+    void scan_extended(unsigned long long extended_start, unsigned partition_number) {
+        unsigned long long ebr = extended_start;
+        unsigned logical = 4;
+        for (size_t hop = 0; hop < 128 && ebr < device_size; ++hop) {
+            if (!read(ebr, 512) || buffer[510] != 0x55 || buffer[511] != 0xAA) {
+                return;
+            }
+            const std::vector<unsigned char> record = buffer;
+            add(ebr, sector_size, "extended boot record (partition " + std::to_string(partition_number) + ")");
+            const unsigned char* entry = record.data() + 446;
+            const unsigned long long first = ebr + load_le(entry + 8, 4) * sector_size;
+            const unsigned long long count = load_le(entry + 12, 4) * sector_size;
+            if (entry[4] != 0 && count > 0 && first < device_size) {
+                scan_volume(first, std::min(count, device_size - first), "partition " + std::to_string(++logical));
+            }
+            const unsigned long long next = load_le(entry + 16 + 8, 4) * sector_size;
+            if (next == 0) {
+                return;
+            }
+            ebr = extended_start + next;
+        }
+    }
+};
+
+// Lista obszarów do wyzerowania przed przebiegiem: zawsze początek i koniec celu, a do tego wykryte struktury;
+// obszary są zaokrąglane do 4 KB (wyrównanie O_DIRECT) i scalane, z połączonymi opisami
+bool detect_metadata_regions(const std::string& device, unsigned long long device_size,
+                             std::vector<MetadataRegion>& regions, std::string& error) {
+    const int fd = open(device.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open target for metadata detection: " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    MetadataScanner scanner(fd, device_size);
+    scanner.add(0, MetadataScanner::head_region, "start of target (boot sector, partition table)");
+    if (device_size > MetadataScanner::head_region) {
+        scanner.add(device_size - MetadataScanner::head_region, MetadataScanner::head_region, "end of target (backup labels)");
+    }
+    if (!scanner.scan_gpt(scanner.sector_size)
+        && !(device_size > scanner.sector_size && scanner.scan_gpt(device_size - scanner.sector_size))
+        && !scanner.scan_mbr()) {
+        scanner.scan_volume(0, device_size, "target");
+    }
+    close(fd);
+
+    const unsigned long long granule = 4096;
+    std::vector<MetadataRegion> found = scanner.regions;
+    for (MetadataRegion& region : found) {
+        const unsigned long long end = std::min(device_size, (region.offset + region.length + granule - 1) / granule * granule);
+        region.offset -= region.offset % granule;
+        region.length = end - region.offset;
+    }
+    std::stable_sort(found.begin(), found.end(), [](const MetadataRegion& left, const MetadataRegion& right) {
+        return left.offset < right.offset;
+    });
+
+    regions.clear();
+    for (const MetadataRegion& region : found) {
+        if (!regions.empty() && region.offset <= regions.back().offset + regions.back().length) {
+            MetadataRegion& last = regions.back();
+            last.length = std::max(last.offset + last.length, region.offset + region.length) - last.offset;
+            if (("; " + last.description + ";").find("; " + region.description + ";") == std::string::npos) {
+                last.description += "; " + region.description;
+            }
+            continue;
+        }
+        regions.push_back(region);
+    }
+    return true;
+}
+
+// Zerowanie obszarów metadanych przed przebiegiem erase/skip, zakończone fdatasync, żeby zniszczenie było trwałe od razu
+int erase_metadata_regions(int fd, const std::vector<MetadataRegion>& regions, const EraseOptions& options, double& seconds) {
+    const unsigned long long start_ns = monotonic_ns();
+    ZeroSource zeros(options.direct_alignment > 0 ? options.direct_alignment : 4096);
+    const size_t alignment = options.direct_alignment;
+
+    for (const MetadataRegion& region : regions) {
+        unsigned long long offset = region.offset;
+        unsigned long long remaining = region.length;
+        while (remaining > 0 && keep_running) {
+            size_t piece = static_cast<size_t>(std::min<unsigned long long>(remaining, 64ULL << 20));
+            if (alignment > 0 && piece % alignment != 0) {
+                // Nierówna końcówka celu przy O_DIRECT idzie przez cache stron
+                if (piece > alignment) {
+                    piece -= piece % alignment;
+                } else {
+                    if (!write_buffered_tail(fd, offset, zeros.data(), piece)) {
+                        if (options.error_log != nullptr) {
+                            options.error_log->record(offset, errno != 0 ? errno : EIO);
+                        }
+                        return EXIT_WRITE_FAILED;
+                    }
+                    offset += piece;
+                    remaining -= piece;
+                    continue;
+                }
+            }
+
+            if (options.throttle != nullptr) {
+                options.throttle->acquire(piece);
+            }
+            zeros.prepare(piece);
+            const ssize_t write_result = pwritev(fd, zeros.vectors.data(), static_cast<int>(zeros.vectors.size()), static_cast<off_t>(offset));
+            if (write_result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (write_result <= 0) {
+                if (options.error_log != nullptr) {
+                    options.error_log->record(offset, write_result < 0 ? errno : EIO);
+                }
+                if (write_result < 0) {
+                    perror("Error writing metadata region");
+                } else {
+                    std::cerr << "Error: no data written to device." << std::endl;
+                }
+                return EXIT_WRITE_FAILED;
+            }
+            offset += static_cast<unsigned long long>(write_result);
+            remaining -= static_cast<unsigned long long>(write_result);
+        }
+    }
+
+    if (fdatasync(fd) < 0 && errno != EINVAL) {
+        if (options.error_log != nullptr) {
+            options.error_log->record(0, errno);
+        }
+        perror("Error syncing metadata regions");
+        return EXIT_WRITE_FAILED;
+    }
+    seconds = (monotonic_ns() - start_ns) / 1e9;
+    return EXIT_OK;
+}
+
+void print_metadata_regions(const std::vector<MetadataRegion>& regions) {
+    for (const MetadataRegion& region : regions) {
+        std::cout << "  " << region.offset << " - " << region.offset + region.length << " (" << format_bytes(region.length)
+                  << "): " << region.description << std::endl;
+    }
+}
+
+// Otwarcie celu i pobranie jego rozmiaru; przy błędzie wypisuje komunikat i zwraca kod wyjścia
+int open_target(const std::string& device, bool read_only, bool direct_mode, int& fd, unsigned long long& device_size) {
+    int open_flags = read_only ? O_RDONLY : O_RDWR;
+    if (direct_mode) {
+        open_flags |= O_DIRECT;
+    }
+
+    fd = open(device.c_str(), open_flags);
+    if (fd < 0) {
+        perror(direct_mode ? "Error opening device with O_DIRECT" : "Error opening device");
+        return EXIT_OPEN_FAILED;
+    }
+
+    // Pobranie rozmiaru dysku
+    device_size = 0;
+    if (ioctl(fd, BLKGETSIZE64, &device_size) < 0) {
+        struct stat st {};
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            device_size = static_cast<unsigned long long>(st.st_size);
+        } else {
+            perror("Error getting device size");
+            close(fd);
+            fd = -1;
+            return EXIT_SIZE_FAILED;
+        }
+    }
+
+    if (device_size == 0) {
+        std::cerr << "Error: target size is 0 bytes." << std::endl;
+        close(fd);
+        fd = -1;
+        return EXIT_SIZE_FAILED;
+    }
+
+    return EXIT_OK;
+}
+
+bool is_block_device(int fd) {
+    struct stat target_stat {};
+    return fstat(fd, &target_stat) == 0 && S_ISBLK(target_stat.st_mode);
+}
+
+OffloadMode resolve_offload_mode(OffloadMode requested, const std::string& device, bool block_device) {
+    if (block_device && (requested == OffloadMode::Discard || requested == OffloadMode::SecureDiscard)
+        && read_block_queue_attribute(device, "discard_zeroes_data") != "1") {
+        std::cerr << "Warning: " << device << " does not guarantee zeroes after discard (discard_zeroes_data), using BLKZEROOUT." << std::endl;
+        return OffloadMode::ZeroOut;
+    }
+    return requested;
+}
+
+// Wynik --auto-tune: limity kolejki urządzenia, wynik próby i wybrane rozmiary/głębokości I/O
+struct AutoTuneResult {
+    unsigned io_min = 0;
+    unsigned io_opt = 0;
+    unsigned long long max_request = 0;
+    unsigned nr_requests = 0;
+    int rotational = -1;
+    bool probe_direct = false;
+    size_t request_size = 0;
+    unsigned depth = 1;
+    double probe_mb_s = 0.0;
+    size_t erase_io_size = 0;
+    size_t verify_io_size = 0;
+};
+
+// Atrybut kolejki urządzenia pod celem: samo urządzenie blokowe albo dysk z systemem plików, na którym leży plik
+std::string read_queue_attribute_for_fd(int fd, const std::string& attribute) {
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        return "";
+    }
+
+    const dev_t device_id = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+    const std::string block_path = "/sys/dev/block/" + std::to_string(major(device_id)) + ":" + std::to_string(minor(device_id));
+    std::string value;
+    std::ifstream attribute_file(block_path + "/queue/" + attribute);
+    if (!attribute_file) {
+        attribute_file.open(block_path + "/../queue/" + attribute);
+    }
+    if (attribute_file) {
+        std::getline(attribute_file, value);
+    }
+    return value;
+}
+
+// Przepustowość odczytu sekwencyjnego: depth wątków czyta po size bajtów kolejne miejsca obszaru próby
+double probe_read_throughput(int fd, unsigned long long region, size_t size, unsigned depth, size_t alignment,
+                             unsigned long long& cursor) {
+    constexpr unsigned long long probe_byte_limit = 256ULL * 1024 * 1024;
+    const auto probe_time = std::chrono::milliseconds(100);
+
+    if (alignment == 0) {
+        posix_fadvise(fd, 0, static_cast<off_t>(region), POSIX_FADV_DONTNEED);
+    }
+
+    std::atomic<unsigned long long> next_offset{cursor};
+    std::atomic<unsigned long long> bytes_read{0};
+    std::atomic<bool> failed{false};
+    const auto start = std::chrono::steady_clock::now();
+    auto reader = [&]() {
+        AlignedBuffer buffer(size, alignment);
+        while (keep_running && !failed.load(std::memory_order_relaxed)
+               && bytes_read.load(std::memory_order_relaxed) < probe_byte_limit
+               && std::chrono::steady_clock::now() - start < probe_time) {
+            const unsigned long long offset = next_offset.fetch_add(size, std::memory_order_relaxed) % (region - region % size);
+            const ssize_t read_result = read_verify_chunk(fd, buffer.data, offset, size, alignment);
+            if (read_result <= 0) {
+                failed = true;
+                break;
+            }
+            bytes_read.fetch_add(static_cast<unsigned long long>(read_result), std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (unsigned index = 1; index < depth; ++index) {
+        readers.emplace_back(reader);
+    }
+    reader();
+    for (std::thread& thread : readers) {
+        thread.join();
+    }
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cursor = next_offset.load();
+    if (failed || elapsed <= 0.0) {
+        return 0.0;
+    }
+    return (bytes_read.load() / (1024.0 * 1024.0)) / elapsed;
+}
+
+// --auto-tune: limity z BLKIOMIN/BLKIOOPT i sysfs, potem krótka próba odczytu (bez zapisu) wybierająca
+// najmniejszy rozmiar żądania i najmniejszą głębokość, które dają co najmniej 90% najlepszej przepustowości
+bool auto_tune_target(const std::string& device, int fd, unsigned long long device_size, AutoTuneResult& result, std::string& error) {
+    constexpr size_t min_request = 64 * 1024;
+    constexpr size_t max_request = 8 * 1024 * 1024;
+    constexpr unsigned max_depth = 32;
+
+    result = AutoTuneResult{};
+    if (ioctl(fd, BLKIOMIN, &result.io_min) < 0) {
+        result.io_min = 0;
+    }
+    if (ioctl(fd, BLKIOOPT, &result.io_opt) < 0) {
+        result.io_opt = 0;
+    }
+    result.max_request = std::strtoull(read_queue_attribute_for_fd(fd, "max_sectors_kb").c_str(), nullptr, 10) * 1024;
+    result.nr_requests = static_cast<unsigned>(std::strtoul(read_queue_attribute_for_fd(fd, "nr_requests").c_str(), nullptr, 10));
+    const std::string rotational = read_queue_attribute_for_fd(fd, "rotational");
+    if (!rotational.empty()) {
+        result.rotational = rotational == "1" ? 1 : 0;
+    }
+
+    // Próba czyta osobnym deskryptorem z pominięciem cache; bez O_DIRECT strony są zrzucane przed każdym pomiarem
+    size_t alignment = 0;
+    int probe_fd = open(device.c_str(), O_RDONLY | O_DIRECT);
+    if (probe_fd >= 0) {
+        alignment = get_direct_io_alignment(probe_fd);
+        result.probe_direct = true;
+    } else {
+        probe_fd = open(device.c_str(), O_RDONLY);
+        if (probe_fd < 0) {
+            error = std::string("Could not open target for auto-tune probe: ") + std::strerror(errno) + ".";
+            return false;
+        }
+    }
+
+    const unsigned long long region = std::min<unsigned long long>(device_size, 1024ULL * 1024 * 1024);
+    if (region < 2 * std::max<size_t>(min_request, result.io_min)) {
+        close(probe_fd);
+        error = "Target is too small for the auto-tune probe (" + format_bytes(device_size) + ").";
+        return false;
+    }
+    unsigned long long cursor = 0;
+    double best = 0.0;
+    std::vector<std::pair<size_t, double>> sizes;
+    for (size_t size = std::max<size_t>(min_request, result.io_min); size <= max_request && size * 2 <= region && keep_running; size *= 2) {
+        if (alignment > 0 && size % alignment != 0) {
+            continue;
+        }
+        const double speed = probe_read_throughput(probe_fd, region, size, 1, alignment, cursor);
+        sizes.emplace_back(size, speed);
+        best = std::max(best, speed);
+    }
+
+    if (sizes.empty() || best <= 0.0) {
+        close(probe_fd);
+        error = "Auto-tune probe could not read the target.";
+        return false;
+    }
+
+    for (const std::pair<size_t, double>& candidate : sizes) {
+        if (candidate.second >= best * 0.9) {
+            result.request_size = candidate.first;
+            break;
+        }
+    }
+
+    // Głębokość: równoległe odczyty wybranym rozmiarem, nie więcej niż pozwala kolejka urządzenia
+    const unsigned depth_limit = result.nr_requests > 0 ? std::min(max_depth, result.nr_requests) : max_depth;
+    std::vector<std::pair<unsigned, double>> depths;
+    best = 0.0;
+    for (unsigned depth = 1; depth <= depth_limit && keep_running; depth *= 2) {
+        const double speed = probe_read_throughput(probe_fd, region, result.request_size, depth, alignment, cursor);
+        depths.emplace_back(depth, speed);
+        best = std::max(best, speed);
+    }
+    close(probe_fd);
+
+    for (const std::pair<unsigned, double>& candidate : depths) {
+        if (candidate.second >= best * 0.9) {
+            result.depth = candidate.first;
+            result.probe_mb_s = candidate.second;
+            break;
+        }
+    }
+
+    // Zapis synchroniczny ma naraz jedno wywołanie, więc dostaje żądanie tyle razy większe, ile wynosi głębokość
+    // (jądro dzieli je na żądania urządzenia); io_uring i wątki weryfikacji używają rozmiaru z próby
+    result.erase_io_size = std::min<size_t>(result.request_size * result.depth, 16 * 1024 * 1024);
+    if (result.io_opt > 0 && result.erase_io_size % result.io_opt != 0 && result.io_opt <= 16 * 1024 * 1024) {
+        result.erase_io_size += result.io_opt - result.erase_io_size % result.io_opt;
+    }
+    result.verify_io_size = result.request_size;
+    return true;
+}
+
+const char* exit_code_name(int exit_code) {
+    switch (exit_code) {
+        case EXIT_OK:
+            return "OK";
+        case EXIT_INVALID_ARGUMENTS:
+            return "invalid arguments";
+        case EXIT_OPEN_FAILED:
+            return "open failed";
+        case EXIT_SIZE_FAILED:
+            return "size failed";
+        case EXIT_SEEK_FAILED:
+            return "seek failed";
+        case EXIT_WRITE_FAILED:
+            return "write failed";
+        case EXIT_USER_ABORTED:
+            return "aborted";
+        default:
+            return "error";
+    }
+}
+
+// Lista celów z pliku: jedna ścieżka w linii, puste linie i linie komentarza (# na początku) są pomijane
+bool read_target_manifest(const std::string& path, std::vector<std::string>& devices, std::string& error) {
+    std::ifstream manifest(path);
+    if (!manifest) {
+        error = "Could not open manifest file '" + path + "'.";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(manifest, line)) {
+        // Komentarzem jest tylko cała linia zaczynająca się od '#'; '#' w środku należy do ścieżki
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        const size_t last = line.find_last_not_of(" \t\r");
+        devices.push_back(line.substr(first, last - first + 1));
+    }
+
+    if (devices.empty()) {
+        error = "Manifest file '" + path + "' does not list any targets.";
+        return false;
+    }
+    return true;
+}
+
+std::string json_escape(const std::string& text) {
+    static const char hex_digits[] = "0123456789abcdef";
+    std::string escaped;
+    for (char symbol : text) {
+        const unsigned char byte = static_cast<unsigned char>(symbol);
+        if (byte < 0x20) {
+            // Znaki sterujące (np. \n, \t w ścieżce lub modelu) jako \u00XX, żeby JSON/JSONL pozostał poprawny
+            escaped += "\\u00";
+            escaped += hex_digits[byte >> 4];
+            escaped += hex_digits[byte & 0x0F];
+            continue;
+        }
+        if (symbol == '"' || symbol == '\\') {
+            escaped += '\\';
+        }
+        escaped += symbol;
+    }
+    return escaped;
+}
+
+// Gęstość bajtów !00 jako jednolinijkowa mapa cieplna (najwyżej 64 pola, każde obejmuje kilka kubełków)
+void print_density_heatmap(unsigned long long target_size, const UsageMap& map) {
+    static const char levels[] = " .:-=+*#%@";
+    const size_t buckets = map.bucket_non_zero.size();
+    if (buckets == 0) {
+        return;
+    }
+
+    const size_t buckets_per_cell = (buckets + 63) / 64;
+    std::string cells;
+    for (size_t first = 0; first < buckets; first += buckets_per_cell) {
+        const size_t last = std::min(buckets, first + buckets_per_cell);
+        unsigned long long non_zero = 0;
+        for (size_t index = first; index < last; ++index) {
+            non_zero += map.bucket_non_zero[index];
+        }
+
+        const unsigned long long cell_bytes = std::min(target_size, last * map.bucket_size) - first * map.bucket_size;
+        const double density = cell_bytes > 0 ? static_cast<double>(non_zero) / cell_bytes : 0.0;
+        const size_t level = non_zero == 0 ? 0 : std::min<size_t>(9, 1 + static_cast<size_t>(density * 9.0));
+        cells += levels[level];
+    }
+
+    unsigned long long extent_bytes = 0;
+    for (const DataExtent& extent : map.extents) {
+        extent_bytes += extent.length;
+    }
+
+    std::cout << "  Density map (" << format_bytes(buckets_per_cell * map.bucket_size)
+              << " per cell, ' ' = empty ... '@' = full):" << std::endl;
+    std::cout << "  [" << cells << "]" << std::endl;
+    std::cout << "  Non-zero extents: " << map.extents.size() << " (" << format_bytes(extent_bytes)
+              << " at " << format_bytes(map.grain) << " granularity)" << std::endl;
+}
+
+// Mapa zajętości w JSON: zakresy !00 (wejście dla --erase-map) i bajty !00 w kubełkach.
+// Zakresy są posortowane i rozłączne, więc mapy z kilku przebiegów łączy się sumą zbiorów.
+bool write_usage_map(const std::string& path, const std::string& device, unsigned long long target_size,
+                     const VerificationStats& stats, const UsageMap& map, std::string& error) {
+    std::ofstream output(path, std::ios::trunc);
+    if (!output) {
+        error = "Could not create map file '" + path + "'.";
+        return false;
+    }
+
+    output << "{\n";
+    output << "  \"version\": 1,\n";
+    output << "  \"device\": \"" << json_escape(device) << "\",\n";
+    output << "  \"size\": " << target_size << ",\n";
+    output << "  \"non_zero_bytes\": " << stats.non_zero_bytes << ",\n";
+    output << "  \"grain\": " << map.grain << ",\n";
+    output << "  \"extents\": [";
+    for (size_t index = 0; index < map.extents.size(); ++index) {
+        output << (index == 0 ? "\n    [" : ",\n    [") << map.extents[index].offset << ", " << map.extents[index].length << "]";
+    }
+    output << (map.extents.empty() ? "],\n" : "\n  ],\n");
+    output << "  \"bucket_size\": " << map.bucket_size << ",\n";
+    output << "  \"bucket_non_zero\": [";
+    for (size_t index = 0; index < map.bucket_non_zero.size(); ++index) {
+        output << (index == 0 ? "" : ", ") << map.bucket_non_zero[index];
+    }
+    output << "]\n}\n";
+
+    output.flush();
+    if (!output) {
+        error = "Could not write map file '" + path + "'.";
+        return false;
+    }
+    return true;
+}
+
+// Odczyt rozmiaru i zakresów !00 z mapy zapisanej przez write_usage_map
+bool read_usage_map(const std::string& path, unsigned long long& target_size, std::vector<DataExtent>& extents, std::string& error) {
+    std::ifstream input(path);
+    if (!input) {
+        error = "Could not open map file '" + path + "'.";
+        return false;
+    }
+
+    std::stringstream content;
+    content << input.rdbuf();
+    const std::string text = content.str();
+    const char* whitespace = " \t\r\n";
+
+    auto value_position = [&](const std::string& key) {
+        const size_t key_position = text.find("\"" + key + "\"");
+        const size_t colon = key_position == std::string::npos ? std::string::npos : text.find(':', key_position);
+        return colon == std::string::npos ? std::string::npos : colon + 1;
+    };
+    auto expect = [&](size_t& position, char symbol) {
+        position = text.find_first_not_of(whitespace, position);
+        if (position == std::string::npos || text[position] != symbol) {
+            return false;
+        }
+        ++position;
+        return true;
+    };
+    auto parse_number = [&](size_t& position, unsigned long long& value) {
+        position = text.find_first_not_of(whitespace, position);
+        if (position == std::string::npos || !std::isdigit(static_cast<unsigned char>(text[position]))) {
+            return false;
+        }
+        char* end = nullptr;
+        errno = 0;
+        value = std::strtoull(text.c_str() + position, &end, 10);
+        position = static_cast<size_t>(end - text.c_str());
+        return errno == 0;
+    };
+
+    unsigned long long version = 0;
+    size_t position = value_position("version");
+    if (position == std::string::npos || !parse_number(position, version) || version != 1) {
+        error = "File '" + path + "' is not a valid eraser map.";
+        return false;
+    }
+
+    position = value_position("size");
+    bool valid = position != std::string::npos && parse_number(position, target_size);
+    position = value_position("extents");
+    valid = valid && position != std::string::npos && expect(position, '[');
+
+    extents.clear();
+    unsigned long long previous_end = 0;
+    while (valid && !expect(position, ']')) {
+        DataExtent extent;
+        valid = (extents.empty() || expect(position, ','))
+            && expect(position, '[') && parse_number(position, extent.offset)
+            && expect(position, ',') && parse_number(position, extent.length) && expect(position, ']')
+            && extent.offset >= previous_end && extent.length <= target_size - std::min(extent.offset, target_size)
+            && extent.offset < target_size;
+        previous_end = extent.offset + extent.length;
+        extents.push_back(extent);
+    }
+
+    if (!valid) {
+        error = "Map file '" + path + "' is corrupted.";
+        return false;
+    }
+    return true;
+}
+
+// Dziennik wznowienia: geometria kasowania, tożsamość dysku i offset, do którego dane są zapisane i zsynchronizowane
+struct ErasureJournal {
+    std::string device;
+    std::string identity;
+    // Numer seryjny/WWID, st_rdev albo inode pliku (get_target_unique_id); bez niego wznowienie jest odrzucane
+    std::string unique_id;
+    unsigned long long device_size = 0;
+    unsigned long long erase_size = 0;
+    unsigned long long skip_size = 0;
+    unsigned long long offset = 0;
+    bool complete = false;
+};
+
+// Zapis atomowy: plik tymczasowy + fsync + rename + fsync katalogu
+bool write_erasure_journal(const std::string& path, const ErasureJournal& journal, std::string& error) {
+    std::ostringstream content;
+    content << "# eraser journal\n"
+            << "version=1\n"
+            << "device=" << journal.device << "\n"
+            << "identity=" << journal.identity << "\n"
+            << "unique_id=" << journal.unique_id << "\n"
+            << "device_size=" << journal.device_size << "\n"
+            << "erase_size=" << journal.erase_size << "\n"
+            << "skip_size=" << journal.skip_size << "\n"
+            << "offset=" << journal.offset << "\n"
+            << "state=" << (journal.complete ? "complete" : "running") << "\n";
+    const std::string data = content.str();
+    const std::string temporary_path = path + ".tmp";
+
+    const int journal_fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (journal_fd < 0) {
+        error = "Could not create journal file '" + temporary_path + "': " + std::strerror(errno) + ".";
+        return false;
+    }
+
+    size_t bytes_written = 0;
+    while (bytes_written < data.size()) {
+        const ssize_t write_result = write(journal_fd, data.data() + bytes_written, data.size() - bytes_written);
+        if (write_result <= 0) {
+            error = "Could not write journal file '" + temporary_path + "'.";
+            close(journal_fd);
+            return false;
+        }
+        bytes_written += static_cast<size_t>(write_result);
+    }
+
+    if (fsync(journal_fd) < 0 || close(journal_fd) < 0) {
+        error = "Could not sync journal file '" + temporary_path + "'.";
+        return false;
+    }
+
+    if (rename(temporary_path.c_str(), path.c_str()) < 0) {
+        error = "Could not replace journal file '" + path + "': " + std::strerror(errno) + ".";
+        return false;
+    }
+
+    const size_t separator = path.rfind('/');
+    const std::string directory = separator == std::string::npos ? "." : (separator == 0 ? "/" : path.substr(0, separator));
+    const int directory_fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (directory_fd >= 0) {
+        fsync(directory_fd);
+        close(directory_fd);
+    }
+    return true;
+}
+
+bool read_erasure_journal(const std::string& path, ErasureJournal& journal, std::string& error) {
+    std::ifstream journal_file(path);
+    if (!journal_file) {
+        error = "Could not open journal file '" + path + "'.";
+        return false;
+    }
+
+    bool has_version = false;
+    bool has_offset = false;
+    std::string line;
+    try {
+        while (std::getline(journal_file, line)) {
+            const size_t separator = line.find('=');
+            if (line.empty() || line[0] == '#' || separator == std::string::npos) {
+                continue;
+            }
+
+            const std::string key = line.substr(0, separator);
+            const std::string value = line.substr(separator + 1);
+            if (key == "version") {
+                has_version = value == "1";
+            } else if (key == "device") {
+                journal.device = value;
+            } else if (key == "identity") {
+                journal.identity = value;
+            } else if (key == "unique_id") {
+                journal.unique_id = value;
+            } else if (key == "device_size") {
+                journal.device_size = std::stoull(value);
+            } else if (key == "erase_size") {
+                journal.erase_size = std::stoull(value);
+            } else if (key == "skip_size") {
+                journal.skip_size = std::stoull(value);
+            } else if (key == "offset") {
+                journal.offset = std::stoull(value);
+                has_offset = true;
+            } else if (key == "state") {
+                journal.complete = value == "complete";
+            }
+        }
+    } catch (const std::exception&) {
+        error = "Journal file '" + path + "' is corrupted.";
+        return false;
+    }
+
+    if (!has_version || !has_offset) {
+        error = "File '" + path + "' is not a valid eraser journal.";
+        return false;
+    }
+    return true;
+}
+
+// Okresowy punkt kontrolny w osobnym wątku: fdatasync celu, potem zapis dziennika.
+// Pętla zapisu tylko publikuje completed_offset, więc nie czeka na synchronizację.
+struct JournalWriter {
+    std::string path;
+    ErasureJournal state;
+    int fd;
+    const EraseProgress& progress;
+    std::chrono::seconds interval;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::string last_error;
+    std::thread worker;
+
+    JournalWriter(const std::string& journal_path, const ErasureJournal& initial_state, int target_fd,
+                  const EraseProgress& erase_progress, unsigned interval_seconds)
+        : path(journal_path), state(initial_state), fd(target_fd), progress(erase_progress), interval(interval_seconds) {
+        worker = std::thread(&JournalWriter::run, this);
+    }
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    ~JournalWriter() {
+        stop();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    bool checkpoint(bool complete) {
+        // Offset odczytany przed fdatasync – wszystko poniżej jest po nim na nośniku
+        const unsigned long long offset = progress.completed_offset.load(std::memory_order_acquire);
+        if (!complete && offset <= state.offset) {
+            return true;
+        }
+
+        if (fdatasync(fd) < 0) {
+            last_error = std::string("Could not sync target for journal checkpoint: ") + std::strerror(errno) + ".";
+            return false;
+        }
+
+        state.offset = offset;
+        state.complete = complete;
+        return write_erasure_journal(path, state, last_error);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (wake.wait_for(lock, interval, [this]() { return stopping; })) {
+                break;
+            }
+
+            lock.unlock();
+            if (!checkpoint(false)) {
+                std::cerr << "\nWarning: " << last_error << std::endl;
+            }
+            lock.lock();
+        }
+    }
+
+    bool finish(bool complete) {
+        stop();
+        return checkpoint(complete);
+    }
+};
+
+// Opis limitów do nagłówka i komunikatów o zmianie
+std::string describe_rate_limits(const RateLimiter& limiter) {
+    const unsigned long long rate = limiter.max_bytes_per_second.load(std::memory_order_relaxed);
+    const unsigned long long iops = limiter.max_iops.load(std::memory_order_relaxed);
+    return (rate > 0 ? format_bytes(rate) + "/s" : std::string("unlimited bandwidth")) + ", "
+        + (iops > 0 ? std::to_string(iops) + " IOPS" : std::string("unlimited IOPS"));
+}
+
+// Zmiana limitów w trakcie pracy: plik --rate-file jest sprawdzany co sekundę i wczytywany po każdej zmianie (mtime)
+struct RateControlFile {
+    std::string path;
+    RateLimiter& limiter;
+    timespec last_mtime {};
+    bool seen = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+
+    RateControlFile(const std::string& control_path, RateLimiter& rate_limiter) : path(control_path), limiter(rate_limiter) {}
+
+    RateControlFile(const RateControlFile&) = delete;
+    RateControlFile& operator=(const RateControlFile&) = delete;
+
+    ~RateControlFile() {
+        stop();
+    }
+
+    // true, gdy plik się zmienił i limity zostały przyjęte; brak pliku oznacza limity z wiersza poleceń
+    bool reload(std::string& error) {
+        struct stat file_stat {};
+        if (stat(path.c_str(), &file_stat) != 0) {
+            return false;
+        }
+        if (seen && file_stat.st_mtim.tv_sec == last_mtime.tv_sec && file_stat.st_mtim.tv_nsec == last_mtime.tv_nsec) {
+            return false;
+        }
+        seen = true;
+        last_mtime = file_stat.st_mtim;
+
+        std::ifstream input(path);
+        std::stringstream content;
+        content << input.rdbuf();
+        unsigned long long rate = limiter.max_bytes_per_second.load(std::memory_order_relaxed);
+        unsigned long long iops = limiter.max_iops.load(std::memory_order_relaxed);
+        if (!input || !parse_rate_limits(content.str(), rate, iops, error)) {
+            if (error.empty()) {
+                error = "Could not read rate file '" + path + "'.";
+            }
+            return false;
+        }
+        limiter.set_limits(rate, iops);
+        return true;
+    }
+
+    void start() {
+        worker = std::thread(&RateControlFile::run, this);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (wake.wait_for(lock, std::chrono::seconds(1), [this]() { return stopping; })) {
+                break;
+            }
+
+            std::string error;
+            if (reload(error)) {
+                std::cout << "\nRate limits changed: " << describe_rate_limits(limiter) << std::endl;
+            } else if (!error.empty()) {
+                std::cerr << "\nWarning: " << error << " Keeping current limits." << std::endl;
+            }
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+};
+
+// Telemetria w formacie JSON Lines (--stats-json/--stats-fd): zdarzenie "progress" co sekundę z liczników
+// EraseProgress i podsumowanie "summary" na końcu. Pętla I/O tylko aktualizuje atomowe liczniki i histogramy,
+// cały zapis odbywa się w osobnym wątku.
+struct TelemetryStream {
+    static constexpr size_t max_samples = 512;
+    static constexpr unsigned long long slow_io_ns = 1000ULL * 1000 * 1000;
+
+    int fd = -1;
+    bool owns_fd = false;
+    std::string operation;
+    std::string device;
+    unsigned long long total_bytes = 0;
+    const EraseProgress* progress = nullptr;
+    LatencyHistogram write_latency;
+    LatencyHistogram read_latency;
+    IoErrorLog errors;
+    std::chrono::steady_clock::time_point start_time;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool finished = false;
+    std::thread worker;
+
+    // Przepływność w kolejnych przedziałach; po zapełnieniu sąsiednie próbki są łączone (przedział x2)
+    std::vector<double> samples;
+    unsigned ticks_per_sample = 1;
+    unsigned pending_ticks = 0;
+    unsigned long long pending_bytes = 0;
+    unsigned long long done_bytes = 0;
+    unsigned long long last_counter = 0;
+    unsigned long long idle_intervals = 0;
+
+    TelemetryStream() = default;
+    TelemetryStream(const TelemetryStream&) = delete;
+    TelemetryStream& operator=(const TelemetryStream&) = delete;
+
+    ~TelemetryStream() {
+        stop();
+        if (owns_fd && fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool open_output(const std::string& path, int stats_fd, std::string& error) {
+        if (!path.empty()) {
+            fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                error = "Could not create statistics file '" + path + "': " + std::strerror(errno) + ".";
+                return false;
+            }
+            owns_fd = true;
+            return true;
+        }
+
+        if (fcntl(stats_fd, F_GETFD) < 0) {
+            error = "Option --stats-fd: descriptor " + std::to_string(stats_fd) + " is not open.";
+            return false;
+        }
+        fd = stats_fd;
+        return true;
+    }
+
+    // Cała linia jednym write(), więc zdarzenia nie mieszają się z innymi zapisami do tego samego potoku
+    void emit(const std::string& line) {
+        size_t written = 0;
+        while (written < line.size()) {
+            const ssize_t result = write(fd, line.data() + written, line.size() - written);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                return;
+            }
+            written += static_cast<size_t>(result);
+        }
+    }
+
+    void start(const std::string& operation_name, const std::string& target, unsigned long long size, const EraseProgress& counters) {
+        operation = operation_name;
+        device = target;
+        total_bytes = size;
+        progress = &counters;
+        start_time = std::chrono::steady_clock::now();
+
+        std::ostringstream line;
+        line << "{\"event\":\"start\",\"operation\":\"" << operation << "\",\"device\":\"" << json_escape(device)
+             << "\",\"total\":" << total_bytes << "}\n";
+        emit(line.str());
+        worker = std::thread(&TelemetryStream::run, this);
+    }
+
+    double elapsed_seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    // Początek właściwej pracy (po odliczaniu i wstępnej weryfikacji): czas, przepływność i przestoje liczone od nowa,
+    // histogramy opóźnień i błędy zostają
+    void restart_timing() {
+        std::lock_guard<std::mutex> lock(mutex);
+        start_time = std::chrono::steady_clock::now();
+        samples.clear();
+        ticks_per_sample = 1;
+        pending_ticks = 0;
+        pending_bytes = 0;
+        done_bytes = 0;
+        last_counter = 0;
+        idle_intervals = 0;
+    }
+
+    // Bajty wykonane od ostatniego odczytu; spadek licznika oznacza nowy przebieg (liczniki zerowane)
+    unsigned long long collect() {
+        const bool erasing = operation == "erase" || operation == "simulate";
+        const unsigned long long counter = erasing
+            ? progress->erased_bytes.load(std::memory_order_relaxed)
+            : progress->processed_bytes.load(std::memory_order_relaxed);
+        const unsigned long long delta = counter >= last_counter ? counter - last_counter : counter;
+        last_counter = counter;
+        done_bytes += delta;
+        return delta;
+    }
+
+    void add_sample(unsigned long long delta) {
+        pending_bytes += delta;
+        if (++pending_ticks < ticks_per_sample) {
+            return;
+        }
+        samples.push_back((pending_bytes / (1024.0 * 1024.0)) / ticks_per_sample);
+        pending_ticks = 0;
+        pending_bytes = 0;
+
+        if (samples.size() == max_samples) {
+            for (size_t index = 0; index < max_samples / 2; ++index) {
+                samples[index] = (samples[2 * index] + samples[2 * index + 1]) / 2.0;
+            }
+            samples.resize(max_samples / 2);
+            ticks_per_sample *= 2;
+        }
+    }
+
+    void emit_progress(double interval_seconds, unsigned long long delta) {
+        const unsigned long long processed = progress->processed_bytes.load(std::memory_order_relaxed);
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3)
+             << "{\"event\":\"progress\",\"elapsed_s\":" << elapsed_seconds()
+             << ",\"processed\":" << processed << ",\"done\":" << done_bytes << ",\"total\":" << total_bytes
+             << ",\"percent\":" << std::setprecision(2) << (total_bytes > 0 ? (processed * 100.0) / total_bytes : 100.0)
+             << ",\"mb_s\":" << (interval_seconds > 0.0 ? (delta / (1024.0 * 1024.0)) / interval_seconds : 0.0)
+             << ",\"errors\":" << errors.total.load(std::memory_order_relaxed) << "}\n";
+        emit(line.str());
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto last_tick = std::chrono::steady_clock::now();
+        while (!stopping) {
+            if (wake.wait_for(lock, std::chrono::seconds(1), [this]() { return stopping; })) {
+                break;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            const double interval = std::chrono::duration<double>(now - last_tick).count();
+            last_tick = now;
+            const unsigned long long delta = collect();
+            if (delta == 0) {
+                ++idle_intervals;
+            }
+            add_sample(delta);
+            emit_progress(interval, delta);
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    static void write_latency_json(std::ostringstream& line, const char* name, const LatencyHistogram& latency) {
+        line << ",\"" << name << "\":{\"count\":" << latency.total.load(std::memory_order_relaxed)
+             << ",\"p50\":" << latency.percentile(0.50) << ",\"p99\":" << latency.percentile(0.99)
+             << ",\"max\":" << latency.max_ns.load(std::memory_order_relaxed) << "}";
+    }
+
+    // Podsumowanie: przepływność w czasie, percentyle opóźnień, przestoje i offsety błędów
+    void finish(int exit_code, const VerificationStats* verify_stats = nullptr) {
+        if (finished || progress == nullptr) {
+            return;
+        }
+        finished = true;
+        stop();
+
+        const unsigned long long delta = collect();
+        if (pending_ticks > 0 || delta > 0) {
+            // Niepełny ostatni przedział trafia do ostatniej próbki
+            const unsigned ticks = pending_ticks + 1;
+            samples.push_back(((pending_bytes + delta) / (1024.0 * 1024.0)) / ticks);
+        }
+
+        const double elapsed = elapsed_seconds();
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3)
+             << "{\"event\":\"summary\",\"operation\":\"" << operation << "\",\"device\":\"" << json_escape(device)
+             << "\",\"exit_code\":" << exit_code << ",\"elapsed_s\":" << elapsed
+             << ",\"bytes\":" << done_bytes << ",\"total\":" << total_bytes
+             << ",\"avg_mb_s\":" << std::setprecision(2) << (elapsed > 0.0 ? (done_bytes / (1024.0 * 1024.0)) / elapsed : 0.0)
+             << ",\"throughput\":{\"interval_s\":" << ticks_per_sample << ",\"mb_s\":[";
+        for (size_t index = 0; index < samples.size(); ++index) {
+            line << (index == 0 ? "" : ",") << samples[index];
+        }
+        line << "]}";
+        write_latency_json(line, "write_latency_ns", write_latency);
+        write_latency_json(line, "read_latency_ns", read_latency);
+        line << ",\"stalls\":{\"slow_ios\":" << write_latency.count_above(slow_io_ns) + read_latency.count_above(slow_io_ns)
+             << ",\"threshold_ms\":" << slow_io_ns / (1000 * 1000) << ",\"idle_intervals\":" << idle_intervals << "}";
+        {
+            std::lock_guard<std::mutex> lock(errors.mutex);
+            line << ",\"errors\":{\"count\":" << errors.total.load(std::memory_order_relaxed) << ",\"offsets\":[";
+            for (size_t index = 0; index < errors.entries.size(); ++index) {
+                line << (index == 0 ? "[" : ",[") << errors.entries[index].first << "," << errors.entries[index].second << "]";
+            }
+            line << "]}";
+        }
+        if (verify_stats != nullptr) {
+            line << ",\"non_zero_bytes\":" << verify_stats->non_zero_bytes << ",\"first_non_zero_offset\":";
+            if (verify_stats->first_non_zero_offset == std::numeric_limits<unsigned long long>::max()) {
+                line << "null";
+            } else {
+                line << verify_stats->first_non_zero_offset;
+            }
+        }
+        line << ",\"peak_rss\":" << peak_rss_bytes() << "}\n";
+        emit(line.str());
+    }
+};
+
+// Odczyt kontrolny w trakcie kasowania: zakresy, które silnik zgłosił jako zakończone (completed_offset),
+// są czytane z pominięciem cache i sprawdzane, podczas gdy kolejne fragmenty są jeszcze zapisywane
+struct ReadBackVerifier {
+    int fd = -1;
+    size_t direct_alignment = 0;
+    unsigned long long device_size;
+    unsigned long long erase_size;
+    unsigned long long skip_size;
+    const std::vector<DataExtent>* data_extents;
+    const EraseProgress& progress;
+    VerifyOptions options;
+    unsigned long long cursor;
+    std::atomic<bool> erase_finished{false};
+    std::atomic<bool> aborted{false};
+    VerificationStats stats;
+    unsigned long long verified_bytes = 0;
+    bool failed = false;
+    std::thread worker;
+
+    ReadBackVerifier(unsigned long long target_size, size_t erase, size_t skip, const EraseOptions& erase_options,
+                     const EraseProgress& erase_progress, const VerifyOptions& verify_options)
+        : device_size(target_size), erase_size(erase), skip_size(skip), data_extents(erase_options.data_extents),
+          progress(erase_progress), options(verify_options), cursor(erase_options.start_offset) {}
+
+    ReadBackVerifier(const ReadBackVerifier&) = delete;
+    ReadBackVerifier& operator=(const ReadBackVerifier&) = delete;
+
+    ~ReadBackVerifier() {
+        aborted = true;
+        if (worker.joinable()) {
+            worker.join();
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // Własny deskryptor z O_DIRECT; gdy system plików go nie wspiera, odczyt idzie przez cache
+    bool start(const std::string& device, std::string& error) {
+        fd = open(device.c_str(), O_RDONLY | O_DIRECT);
+        if (fd >= 0) {
+            direct_alignment = get_direct_io_alignment(fd);
+        } else {
+            fd = open(device.c_str(), O_RDONLY);
+            if (fd < 0) {
+                error = std::string("Could not open target for read-back verification: ") + std::strerror(errno) + ".";
+                return false;
+            }
+            std::cerr << "Warning: O_DIRECT is not supported by target, read-back verification uses page cache." << std::endl;
+        }
+
+        if (direct_alignment > 0 && options.chunk_size % direct_alignment != 0) {
+            options.chunk_size += direct_alignment - options.chunk_size % direct_alignment;
+        }
+        options.direct_alignment = direct_alignment;
+        worker = std::thread(&ReadBackVerifier::run, this);
+        return true;
+    }
+
+    // Kolejny skasowany zakres za kursorem; czeka, aż silnik kasowania go zakończy
+    bool next_range(unsigned long long& range_offset, size_t& range_length) {
+        const unsigned long long stride = erase_size + skip_size;
+        while (keep_running && !aborted.load(std::memory_order_relaxed)) {
+            const bool finished = erase_finished.load(std::memory_order_acquire);
+            const unsigned long long completed = progress.completed_offset.load(std::memory_order_acquire);
+
+            const unsigned long long position = cursor % stride;
+            if (position >= erase_size) {
+                cursor += stride - position;
+                continue;
+            }
+            if (cursor >= device_size) {
+                return false;
+            }
+
+            unsigned long long end = std::min({cursor - position + erase_size, device_size,
+                                               cursor + static_cast<unsigned long long>(options.chunk_size)});
+            if (data_extents != nullptr) {
+                unsigned long long hole_length = 0;
+                unsigned long long data_length = 0;
+                split_at_holes(*data_extents, cursor, end, hole_length, data_length);
+                if (data_length == 0) {
+                    cursor = end;
+                    continue;
+                }
+                cursor += hole_length;
+                end = cursor + data_length;
+            }
+
+            if (end <= completed) {
+                range_offset = cursor;
+                range_length = static_cast<size_t>(end - cursor);
+                cursor = end;
+                return true;
+            }
+
+            if (finished) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    void run() {
+        const ZeroScanner& scanner = active_zero_scanner();
+        auto verify_start = std::chrono::high_resolution_clock::now();
+        ReadAheadPipeline pipeline(fd, options.chunk_size, options.buffer_count, options.direct_alignment,
+            [this](unsigned long long& range_offset, size_t& range_length) {
+                return next_range(range_offset, range_length);
+            }, options.read_latency, options.throttle);
+
+        ReadAheadPipeline::Chunk chunk;
+        while (pipeline.next(chunk)) {
+            if (chunk.read_result < 0 || static_cast<size_t>(chunk.read_result) < chunk.length) {
+                if (options.error_log != nullptr) {
+                    options.error_log->record(chunk.offset, chunk.error != 0 ? chunk.error : EIO);
+                }
+                failed = true;
+                aborted = true;
+                break;
+            }
+
+            verified_bytes += static_cast<unsigned long long>(chunk.read_result);
+            const ZeroScanResult scan = scan_verify_chunk(scanner, chunk.data, chunk.offset, static_cast<size_t>(chunk.read_result),
+                                                          false, nullptr, options.expected_pattern);
+            if (scan.first_non_zero != ZeroScanResult::npos) {
+                stats.first_non_zero_offset = std::min(stats.first_non_zero_offset, chunk.offset + scan.first_non_zero);
+            }
+            stats.bytes_read += static_cast<unsigned long long>(chunk.read_result);
+            stats.non_zero_bytes += scan.non_zero_bytes;
+            pipeline.release();
+        }
+
+        stats.zero_bytes = stats.bytes_read - stats.non_zero_bytes;
+        stats.duration_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - verify_start).count();
+    }
+
+    // Po zakończeniu kasowania doczytuje pozostałe zakresy i czeka na wynik
+    void finish() {
+        erase_finished.store(true, std::memory_order_release);
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+};
+
+struct BatchTarget {
+    std::string device;
+    std::string disk_type;
+    std::string disk_info;
+    std::string group;
+    int fd = -1;
+    unsigned long long device_size = 0;
+    int result = EXIT_OK;
+    EraseOptions options;
+    EraseProgress progress;
+    EraseStats stats;
+    std::atomic<bool> finished{false};
+};
+
+// Tryb wsadowy: każdy dysk ma własny wątek, a dyski na jednym kontrolerze dzielą budżet zapisów w locie
+int run_batch_erase(
+    const std::vector<std::string>& devices,
+    size_t erase_size,
+    size_t skip_size,
+    const EraseOptions& base_options,
+    bool direct_mode,
+    unsigned group_inflight
+) {
+    std::vector<std::unique_ptr<BatchTarget>> targets;
+    std::map<std::string, std::unique_ptr<IoBudget>> group_budgets;
+    unsigned long long total_size = 0;
+
+    std::cout << "Targets: " << devices.size() << std::endl;
+    for (const std::string& device : devices) {
+        std::unique_ptr<BatchTarget> target(new BatchTarget);
+        target->device = device;
+        target->disk_type = get_disk_type(device);
+        target->disk_info = get_disk_info(device);
+        target->group = get_controller_group(device);
+        target->options = base_options;
+        target->options.show_progress = false;
+        target->options.progress = &target->progress;
+
+        target->result = open_target(device, base_options.simulate, direct_mode, target->fd, target->device_size);
+        if (target->result == EXIT_OK && direct_mode) {
+            const size_t alignment = get_direct_io_alignment(target->fd);
+            if (erase_size % alignment != 0 || skip_size % alignment != 0) {
+                std::cerr << "Error: " << device << " requires erase/skip sizes aligned to " << alignment << " bytes for --direct." << std::endl;
+                close(target->fd);
+                target->fd = -1;
+                target->result = EXIT_INVALID_ARGUMENTS;
+            }
+            target->options.direct_alignment = alignment;
+        }
+
+        if (target->result == EXIT_OK) {
+            target->options.offload = resolve_offload_mode(base_options.offload, device, is_block_device(target->fd));
+            std::unique_ptr<IoBudget>& budget = group_budgets[target->group];
+            if (budget == nullptr) {
+                budget.reset(new IoBudget(group_inflight));
+            }
+            target->options.io_budget = budget.get();
+            total_size += target->device_size;
+        } else {
+            target->finished = true;
+        }
+
+        std::cout << "  " << device << " | " << target->device_size / (1024 * 1024) << " MB | " << target->disk_type
+                  << " | " << target->disk_info << " | controller " << target->group;
+        if (target->result != EXIT_OK) {
+            std::cout << " | " << exit_code_name(target->result);
+        }
+        std::cout << std::endl;
+        targets.push_back(std::move(target));
+    }
+    std::cout << "Controller groups: " << group_budgets.size() << " (max " << group_inflight << " writes in flight per group)" << std::endl;
+
+    // Odliczanie przed startem
+    countdown();
+    if (!keep_running) {
+        for (const std::unique_ptr<BatchTarget>& target : targets) {
+            if (target->fd >= 0) {
+                close(target->fd);
+            }
+        }
+        return EXIT_OK;
+    }
 
-    if (lseek(fd, 0, SEEK_SET) < 0) {
-        error_message = "Could not seek to the beginning for verification.";
-        return false;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (const std::unique_ptr<BatchTarget>& target : targets) {
+        if (target->fd < 0) {
+            continue;
+        }
+        BatchTarget* job = target.get();
+        workers.emplace_back([job, erase_size, skip_size]() {
+            job->result = erase_target(job->fd, job->device_size, erase_size, skip_size, job->options, job->stats);
+            job->finished.store(true, std::memory_order_release);
+        });
     }
 
-    auto verify_start = std::chrono::high_resolution_clock::now();
-    unsigned long long offset = 0;
-    while (offset < target_size && keep_running) {
-        const size_t bytes_to_read = static_cast<size_t>(std::min<unsigned long long>(verify_chunk_size, target_size - offset));
-        const ssize_t read_result = read(fd, read_buffer.data(), bytes_to_read);
+    while (true) {
+        size_t finished_count = 0;
+        unsigned long long processed_bytes = 0;
+        unsigned long long erased_bytes = 0;
+        for (const std::unique_ptr<BatchTarget>& target : targets) {
+            if (target->finished.load(std::memory_order_acquire)) {
+                ++finished_count;
+            }
+            processed_bytes += target->progress.processed_bytes.load(std::memory_order_relaxed);
+            erased_bytes += target->progress.erased_bytes.load(std::memory_order_relaxed);
+        }
 
-        if (read_result < 0) {
-            error_message = "Read error while verifying target content.";
-            return false;
+        if (total_size > 0) {
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start_time;
+            const double speed = elapsed.count() > 0.0 ? (erased_bytes / (1024.0 * 1024.0)) / elapsed.count() : 0.0;
+            const std::string label = "[" + std::to_string(finished_count) + "/" + std::to_string(targets.size()) + " done] ";
+            print_progress(processed_bytes * 100.0 / total_size, speed, erased_bytes * 100.0 / total_size, label);
         }
 
-        if (read_result == 0) {
+        if (finished_count == targets.size()) {
             break;
         }
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
 
-        unsigned long long chunk_non_zero = 0;
-        for (ssize_t index = 0; index < read_result; ++index) {
-            if (read_buffer[static_cast<size_t>(index)] != 0x00) {
-                if (stats.first_non_zero_offset == std::numeric_limits<unsigned long long>::max()) {
-                    stats.first_non_zero_offset = offset + static_cast<unsigned long long>(index);
-                }
-                ++chunk_non_zero;
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
 
-                if (stop_on_first_non_zero) {
-                    stats.non_zero_bytes += 1;
-                    stats.bytes_read += static_cast<unsigned long long>(index + 1);
-                    stats.zero_bytes = stats.bytes_read - stats.non_zero_bytes;
-                    auto verify_end = std::chrono::high_resolution_clock::now();
-                    std::chrono::duration<double> verify_duration = verify_end - verify_start;
-                    stats.duration_seconds = verify_duration.count();
-                    return true;
-                }
-            }
-        }
+    std::cout << (keep_running ? "\nBatch erasure finished." : "\nBatch erasure interrupted by user.") << std::endl;
+    std::cout << "Batch summary:" << std::endl;
 
-        stats.bytes_read += static_cast<unsigned long long>(read_result);
-        stats.non_zero_bytes += chunk_non_zero;
-        stats.zero_bytes = stats.bytes_read - stats.non_zero_bytes;
-        offset += static_cast<unsigned long long>(read_result);
+    int exit_code = EXIT_OK;
+    for (const std::unique_ptr<BatchTarget>& target : targets) {
+        const double erased_percentage = target->device_size > 0 ? (target->stats.total_erased * 100.0) / target->device_size : 0.0;
+        const double avg_speed = target->stats.duration_seconds > 0.0
+            ? (target->stats.total_erased / (1024.0 * 1024.0)) / target->stats.duration_seconds
+            : 0.0;
+        std::cout << "  " << target->device << ": " << exit_code_name(target->result) << " (exit " << target->result << ")"
+                  << " | Erased: " << format_bytes(target->stats.total_erased)
+                  << " (" << std::fixed << std::setprecision(2) << erased_percentage << "%)"
+                  << " | Time: " << target->stats.duration_seconds << " s"
+                  << " | Average speed: " << avg_speed << " MB/s" << std::endl;
 
-        if (show_progress) {
-            auto now = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double> elapsed = now - verify_start;
-            const double percentage = target_size > 0 ? (stats.bytes_read * 100.0) / target_size : 0.0;
-            const double speed_mb_s = elapsed.count() > 0.0
-                ? (stats.bytes_read / (1024.0 * 1024.0)) / elapsed.count()
-                : 0.0;
-            print_verification_progress(percentage, speed_mb_s);
+        if (target->result != EXIT_OK && exit_code == EXIT_OK) {
+            exit_code = target->result;
+        }
+        if (target->fd >= 0) {
+            close(target->fd);
         }
     }
+    std::cout << "Peak memory (RSS): " << format_bytes(peak_rss_bytes()) << std::endl;
 
-    auto verify_end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> verify_duration = verify_end - verify_start;
-    stats.duration_seconds = verify_duration.count();
-    return true;
+    return exit_code;
 }
 
-bool ask_user_to_continue() {
-    std::string answer;
-    std::cout << "Detected non-zero bytes on target. Start erasing data? [y/N]: ";
-    std::getline(std::cin, answer);
+// Parametry trybu --bench: macierz rozmiarów fragmentu, liczby wątków weryfikacji i trybów I/O
+struct BenchOptions {
+    unsigned long long size = 256ULL * 1024 * 1024;
+    std::vector<size_t> chunk_sizes;
+    std::vector<unsigned> threads;
+    std::vector<std::string> modes{"sync", "sync-direct", "io_uring", "io_uring-direct", "null"};
+    std::string format = "csv";
+    std::string output_path;
+};
 
-    if (!std::cin.good()) {
-        return false;
+struct BenchResult {
+    std::string operation;
+    std::string mode;
+    size_t chunk_size = 0;
+    unsigned threads = 1;
+    unsigned queue_depth = 0;
+    unsigned long long bytes = 0;
+    double seconds = 0.0;
+    double cpu_seconds = 0.0;
+    unsigned long long operations = 0;
+    unsigned long long latency_p50_ns = 0;
+    unsigned long long latency_p99_ns = 0;
+    unsigned long long latency_max_ns = 0;
+    int exit_code = EXIT_OK;
+
+    double mb_per_second() const {
+        return seconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / seconds : 0.0;
     }
 
-    std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char character) {
-        return static_cast<char>(std::tolower(character));
-    });
+    double cpu_seconds_per_gb() const {
+        return bytes > 0 ? cpu_seconds / (bytes / (1024.0 * 1024.0 * 1024.0)) : 0.0;
+    }
+};
 
-    return answer == "y" || answer == "yes";
+bool is_bench_mode_name(const std::string& mode) {
+    return mode == "sync" || mode == "sync-direct" || mode == "io_uring" || mode == "io_uring-direct" || mode == "null";
 }
 
-bool parse_size_mb(const char* raw_value, const char* field_name, bool allow_zero, size_t& out_bytes, std::string& error) {
-    const std::string value = raw_value != nullptr ? raw_value : "";
-    if (value.empty()) {
-        error = std::string("Field '") + field_name + "' is empty.";
-        return false;
-    }
-
-    if (value[0] == '-') {
-        error = std::string("Field '") + field_name + "' cannot be negative.";
-        return false;
-    }
+// Czas CPU całego procesu (wszystkie wątki, użytkownik + jądro)
+double process_cpu_seconds() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
 
-    size_t parsed_chars = 0;
-    unsigned long long mb_value = 0;
+// Zapis na nośnik i usunięcie stron celu z cache, by kolejny pomiar nie czytał z pamięci
+void drop_target_cache(int fd) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
 
-    try {
-        mb_value = std::stoull(value, &parsed_chars, 10);
-    } catch (const std::invalid_argument&) {
-        error = std::string("Field '") + field_name + "' must be an integer number in MB (example: 8).";
-        return false;
-    } catch (const std::out_of_range&) {
-        error = std::string("Field '") + field_name + "' is too large.";
-        return false;
-    }
+void fill_bench_latency(BenchResult& result, const LatencyHistogram& latency) {
+    result.operations = latency.total.load(std::memory_order_relaxed);
+    result.latency_p50_ns = latency.percentile(0.50);
+    result.latency_p99_ns = latency.percentile(0.99);
+    result.latency_max_ns = latency.max_ns.load(std::memory_order_relaxed);
+}
 
-    if (parsed_chars != value.size()) {
-        error = std::string("Field '") + field_name + "' contains invalid characters: '" + value + "'.";
-        return false;
+bool write_bench_results(const BenchOptions& bench, const std::string& target, const std::vector<BenchResult>& results, std::string& error) {
+    std::ofstream file;
+    if (!bench.output_path.empty()) {
+        file.open(bench.output_path, std::ios::trunc);
+        if (!file) {
+            error = "Could not create benchmark output file '" + bench.output_path + "'.";
+            return false;
+        }
     }
+    std::ostream& output = bench.output_path.empty() ? std::cout : file;
+    output << std::fixed;
 
-    if (!allow_zero && mb_value == 0) {
-        error = std::string("Field '") + field_name + "' must be greater than 0 MB.";
-        return false;
+    if (bench.format == "json") {
+        output << "{\n";
+        output << "  \"version\": 1,\n";
+        output << "  \"target\": \"" << json_escape(target) << "\",\n";
+        output << "  \"size\": " << bench.size << ",\n";
+        output << "  \"zero_scan\": \"" << active_zero_scanner().name << "\",\n";
+        output << "  \"results\": [";
+        for (size_t index = 0; index < results.size(); ++index) {
+            const BenchResult& result = results[index];
+            output << (index == 0 ? "\n" : ",\n") << std::setprecision(6)
+                   << "    {\"operation\": \"" << result.operation << "\", \"mode\": \"" << result.mode << "\""
+                   << ", \"chunk_size\": " << result.chunk_size << ", \"threads\": " << result.threads
+                   << ", \"queue_depth\": " << result.queue_depth << ", \"bytes\": " << result.bytes
+                   << ", \"seconds\": " << result.seconds << ", \"mb_s\": " << std::setprecision(2) << result.mb_per_second()
+                   << ", \"cpu_s_per_gb\": " << std::setprecision(4) << result.cpu_seconds_per_gb()
+                   << ", \"ios\": " << result.operations << ", \"latency_ns\": {\"p50\": " << result.latency_p50_ns
+                   << ", \"p99\": " << result.latency_p99_ns << ", \"max\": " << result.latency_max_ns << "}"
+                   << ", \"exit_code\": " << result.exit_code << "}";
+        }
+        output << (results.empty() ? "]\n}\n" : "\n  ]\n}\n");
+    } else {
+        output << "operation,mode,chunk_kb,threads,queue_depth,bytes,seconds,mb_s,cpu_s_per_gb,ios,lat_p50_us,lat_p99_us,lat_max_us,exit_code\n";
+        for (const BenchResult& result : results) {
+            output << result.operation << "," << result.mode << "," << result.chunk_size / 1024 << "," << result.threads << ","
+                   << result.queue_depth << "," << result.bytes << "," << std::setprecision(6) << result.seconds << ","
+                   << std::setprecision(2) << result.mb_per_second() << "," << std::setprecision(4) << result.cpu_seconds_per_gb() << ","
+                   << result.operations << "," << std::setprecision(1) << result.latency_p50_ns / 1000.0 << ","
+                   << result.latency_p99_ns / 1000.0 << "," << result.latency_max_ns / 1000.0 << "," << result.exit_code << "\n";
+        }
     }
 
-    const unsigned long long bytes_per_mb = 1024ULL * 1024ULL;
-    if (mb_value > (std::numeric_limits<size_t>::max() / bytes_per_mb)) {
-        error = std::string("Field '") + field_name + "' is too large for this system.";
+    output.flush();
+    if (!output) {
+        error = "Could not write benchmark results.";
         return false;
     }
-
-    out_bytes = static_cast<size_t>(mb_value * bytes_per_mb);
     return true;
 }
 
-std::string format_bytes(unsigned long long bytes) {
-    static const char* units[] = {"B", "KB", "MB", "GB", "TB", "PB"};
-    double value = static_cast<double>(bytes);
-    size_t unit_index = 0;
-
-    while (value >= 1024.0 && unit_index < (sizeof(units) / sizeof(units[0])) - 1) {
-        value /= 1024.0;
-        ++unit_index;
-    }
+// Tryb --bench: kasowanie i weryfikacja prawdziwymi ścieżkami programu na pliku/urządzeniu testowym.
+// Backend "null" pisze do /dev/null i czyta z /dev/zero, więc mierzy wyłącznie narzut samego programu.
+int run_benchmark(const std::string& target, size_t skip_size, const BenchOptions& bench, unsigned queue_depth, unsigned buffer_count) {
+    const bool needs_target = std::any_of(bench.modes.begin(), bench.modes.end(),
+        [](const std::string& mode) { return mode != "null"; });
+    unsigned long long bench_size = bench.size;
 
-    std::ostringstream stream;
-    stream << std::fixed << std::setprecision(2) << value << " " << units[unit_index];
-    return stream.str();
-}
+    if (needs_target) {
+        // Brakujący plik testowy jest tworzony, za krótki – wydłużany do --bench-size
+        struct stat target_stat {};
+        if (stat(target.c_str(), &target_stat) != 0) {
+            const int created = open(target.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (created < 0) {
+                perror("Error creating benchmark file");
+                return EXIT_OPEN_FAILED;
+            }
+            close(created);
+            target_stat.st_mode = S_IFREG;
+            target_stat.st_size = 0;
+        }
 
-void print_help(const char* program_name) {
-    std::cout << "Usage:\n";
-    std::cout << "  " << program_name << " <device_or_file> <erase_size_MB> <skip_size_MB> [options]\n\n";
-    std::cout << "Arguments:\n";
-    std::cout << "  <device_or_file>   Target block device (e.g. /dev/sdb) or file for simulation\n";
-    std::cout << "  <erase_size_MB>    Size of zeroed chunk in MB (must be > 0)\n";
-    std::cout << "  <skip_size_MB>     Size of skipped chunk in MB\n\n";
-    std::cout << "Options:\n";
-    std::cout << "  --simulate         Simulation mode (no writes are performed)\n";
-    std::cout << "  --verify-zero      Scan target and verify bytes are 00 before erase\n";
-    std::cout << "  --verify-only      Verify target and print usage report (no erase)\n";
-    std::cout << "  -q, --quiet-errors Print one-line errors only (no full help on error)\n";
-    std::cout << "  -h, --help         Show this help message\n\n";
-    std::cout << "Exit codes:\n";
-    std::cout << "  0  Success\n";
-    std::cout << "  2  Invalid arguments or values\n";
-    std::cout << "  3  Open target failed\n";
-    std::cout << "  4  Could not determine target size\n";
-    std::cout << "  5  Seek failed\n";
-    std::cout << "  6  Write failed\n";
-    std::cout << "  7  User aborted operation\n\n";
-    std::cout << "Examples:\n";
-    std::cout << "  " << program_name << " /dev/sdb 8 0\n";
-    std::cout << "  " << program_name << " /dev/sdb 8 8\n";
-    std::cout << "  " << program_name << " /dev/sdb 8 0 --verify-zero\n";
-    std::cout << "  " << program_name << " /dev/sdb 1 0 --verify-only\n";
-    std::cout << "  " << program_name << " test.img 4 4 --simulate\n";
-    std::cout << "  " << program_name << " test.img abc 4 --simulate --quiet-errors\n";
-}
+        int fd = -1;
+        unsigned long long target_size = 0;
+        if (S_ISREG(target_stat.st_mode) && static_cast<unsigned long long>(target_stat.st_size) < bench_size) {
+            fd = open(target.c_str(), O_RDWR);
+            if (fd < 0 || ftruncate(fd, static_cast<off_t>(bench_size)) != 0) {
+                perror("Error resizing benchmark file");
+                if (fd >= 0) {
+                    close(fd);
+                }
+                return EXIT_SIZE_FAILED;
+            }
+            close(fd);
+        }
 
-void print_error(const char* program_name, const std::string& message, bool quiet_errors) {
-    std::cerr << "Error: " << message << std::endl;
-    if (!quiet_errors) {
-        print_help(program_name);
+        const int open_result = open_target(target, false, false, fd, target_size);
+        if (open_result != EXIT_OK) {
+            return open_result;
+        }
+        close(fd);
+        bench_size = std::min(bench_size, target_size);
     }
-}
 
-// Obsługa sygnału Ctrl+C
-void handle_signal(int signal) {
-    if (signal == SIGINT) {
-        keep_running = false;
-        std::cout << "\nProcess interrupted by user. Exiting..." << std::endl;
+    std::cout << "Benchmark target: " << (needs_target ? target : std::string("null")) << std::endl;
+    std::cout << "Benchmark size: " << format_bytes(bench_size) << " per run, zero scan " << active_zero_scanner().name << std::endl;
+    if (needs_target) {
+        std::cout << "WARNING: the first " << format_bytes(bench_size) << " of the target will be overwritten." << std::endl;
+        countdown();
+        if (!keep_running) {
+            return EXIT_USER_ABORTED;
+        }
     }
-}
 
-// Pobieranie modelu i producenta dysku
-std::string get_disk_info(const std::string& device) {
-    if (device.rfind("/dev/", 0) != 0) {
-        return "N/A";
-    }
+    std::vector<BenchResult> results;
+    for (const std::string& mode : bench.modes) {
+        if (!keep_running) {
+            break;
+        }
 
-    std::string model, vendor;
-    std::ifstream vendor_file("/sys/block/" + device.substr(5) + "/device/vendor");
-    std::ifstream model_file("/sys/block/" + device.substr(5) + "/device/model");
+        const bool null_mode = mode == "null";
+        const bool direct = mode.size() > 7 && mode.compare(mode.size() - 7, 7, "-direct") == 0;
+        const bool uring = mode.compare(0, 8, "io_uring") == 0;
 
-    if (vendor_file) {
-        std::getline(vendor_file, vendor);
-    }
-    if (model_file) {
-        std::getline(model_file, model);
-    }
+        int write_fd = -1;
+        int read_fd = -1;
+        size_t alignment = 0;
+        if (null_mode) {
+            write_fd = open("/dev/null", O_WRONLY);
+            read_fd = open("/dev/zero", O_RDONLY);
+        } else {
+            write_fd = open(target.c_str(), O_RDWR | (direct ? O_DIRECT : 0));
+            read_fd = write_fd;
+            if (write_fd >= 0 && direct) {
+                alignment = get_direct_io_alignment(write_fd);
+            }
+        }
+        if (write_fd < 0 || read_fd < 0) {
+            std::cerr << "Warning: mode " << mode << " skipped (" << std::strerror(errno) << ")." << std::endl;
+            if (write_fd >= 0) {
+                close(write_fd);
+            }
+            if (read_fd >= 0 && read_fd != write_fd) {
+                close(read_fd);
+            }
+            continue;
+        }
 
-    return vendor + " " + model;
-}
+        for (size_t chunk_size : bench.chunk_sizes) {
+            if (!keep_running) {
+                break;
+            }
+            if (alignment > 0 && (chunk_size % alignment != 0 || skip_size % alignment != 0)) {
+                std::cerr << "Warning: " << mode << " with " << format_bytes(chunk_size) << " chunks skipped (not aligned to "
+                          << alignment << " bytes)." << std::endl;
+                continue;
+            }
 
-// Pobieranie rodzaju dysku (SATA, NVMe, USB)
-std::string get_disk_type(const std::string& device) {
-    if (device.find("nvme") != std::string::npos) return "NVMe";
-    if (device.find("sd") != std::string::npos) return "SATA/USB";
-    return "Unknown";
-}
+            LatencyHistogram latency;
+            EraseOptions erase_options;
+            erase_options.engine = uring ? EraseEngine::IoUring : EraseEngine::Sync;
+            erase_options.queue_depth = queue_depth;
+            erase_options.direct_alignment = alignment;
+            erase_options.show_progress = false;
+            erase_options.write_latency = &latency;
 
-// Odliczanie przed startem
-void countdown() {
-    for (int i = 5; i > 0; --i) {
-        if (!keep_running) return;
-        std::cout << "\rStarting in " << i << "... ";
-        std::cout.flush();
-        sleep(1);
+            // Czas kasowania obejmuje końcowe fdatasync z erase_target, więc tryb buforowany nie mierzy samego cache
+            if (!null_mode) {
+                drop_target_cache(write_fd);
+            }
+            BenchResult erase_result;
+            erase_result.operation = "erase";
+            erase_result.mode = mode;
+            erase_result.chunk_size = chunk_size;
+            erase_result.queue_depth = uring ? queue_depth : 1;
+            EraseStats erase_stats;
+            const double erase_cpu_start = process_cpu_seconds();
+            const auto erase_start = std::chrono::steady_clock::now();
+            erase_result.exit_code = erase_target(write_fd, bench_size, chunk_size, skip_size, erase_options, erase_stats);
+            erase_result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - erase_start).count();
+            erase_result.cpu_seconds = process_cpu_seconds() - erase_cpu_start;
+            erase_result.bytes = erase_stats.written_bytes;
+            fill_bench_latency(erase_result, latency);
+            results.push_back(erase_result);
+            std::cout << "  erase  " << std::left << std::setw(16) << mode << std::right << std::setw(10) << format_bytes(chunk_size)
+                      << " | " << std::fixed << std::setprecision(2) << std::setw(9) << erase_result.mb_per_second() << " MB/s"
+                      << " | p99 " << std::setprecision(1) << erase_result.latency_p99_ns / 1000.0 << " us" << std::endl;
+
+            // Weryfikacja nie ma silnika io_uring, więc dla tych trybów mierzone jest tylko kasowanie
+            for (unsigned threads : bench.threads) {
+                if (uring || !keep_running) {
+                    break;
+                }
+
+                VerifyOptions verify_options;
+                verify_options.direct_alignment = alignment;
+                verify_options.threads = threads;
+                verify_options.chunk_size = chunk_size;
+                verify_options.buffer_count = buffer_count;
+                verify_options.read_latency = &latency;
+                latency.reset();
+                if (!null_mode) {
+                    drop_target_cache(read_fd);
+                }
+
+                BenchResult verify_result;
+                verify_result.operation = "verify";
+                verify_result.mode = mode;
+                verify_result.chunk_size = chunk_size;
+                verify_result.threads = threads;
+                verify_result.queue_depth = threads > 1 ? threads : buffer_count;
+                VerificationStats verify_stats;
+                std::string verify_error;
+                const double verify_cpu_start = process_cpu_seconds();
+                const auto verify_start = std::chrono::steady_clock::now();
+                if (!verify_target_content(read_fd, bench_size, verify_options, false, false, verify_stats, verify_error)) {
+                    std::cerr << "Error: " << verify_error << std::endl;
+                    verify_result.exit_code = EXIT_SIZE_FAILED;
+                }
+                verify_result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - verify_start).count();
+                verify_result.cpu_seconds = process_cpu_seconds() - verify_cpu_start;
+                verify_result.bytes = verify_stats.bytes_read;
+                fill_bench_latency(verify_result, latency);
+                results.push_back(verify_result);
+                std::cout << "  verify " << std::left << std::setw(16) << mode << std::right << std::setw(10) << format_bytes(chunk_size)
+                          << " | " << std::fixed << std::setprecision(2) << std::setw(9) << verify_result.mb_per_second() << " MB/s"
+                          << " | p99 " << std::setprecision(1) << verify_result.latency_p99_ns / 1000.0 << " us"
+                          << " | threads " << threads << std::endl;
+            }
+        }
+
+        close(write_fd);
+        if (read_fd != write_fd) {
+            close(read_fd);
+        }
     }
-    std::cout << "Start!" << std::endl;
-}
 
-// Wyświetlanie progresu
-void print_progress(double percentage, double speed, double erased_percentage) {
-    std::cout << "\r\033[KProgress: " << std::fixed << std::setprecision(2) << percentage
-              << "% | Erased: " << erased_percentage
-              << "% | Speed: " << speed << " MB/s";
-    std::cout.flush();
+    if (!keep_running) {
+        std::cout << "Benchmark interrupted by user." << std::endl;
+    }
+
+    std::string output_error;
+    if (!write_bench_results(bench, needs_target ? target : std::string("null"), results, output_error)) {
+        std::cerr << "Error: " << output_error << std::endl;
+        return EXIT_WRITE_FAILED;
+    }
+    if (!bench.output_path.empty()) {
+        std::cout << "Benchmark results written to: " << bench.output_path << std::endl;
+    }
+
+    if (!keep_running) {
+        return EXIT_USER_ABORTED;
+    }
+    for (const BenchResult& result : results) {
+        if (result.exit_code != EXIT_OK) {
+            return result.exit_code;
+        }
+    }
+    return EXIT_OK;
 }
 
 int main(int argc, char* argv[]) {
@@ -320,6 +5794,42 @@ int main(int argc, char* argv[]) {
     bool quiet_errors = false;
     bool verify_zero_mode = false;
     bool verify_only_mode = false;
+    bool direct_mode = false;
+    unsigned group_inflight = 8;
+    std::string journal_path;
+    bool resume_mode = false;
+    unsigned journal_interval = 10;
+    std::string map_path;
+    std::string erase_map_path;
+    bool erase_verify_mode = false;
+    bool metadata_first_mode = false;
+    std::vector<PassPattern> pattern_list;
+    unsigned long long pass_repeats = 1;
+    uint64_t pattern_seed = 0;
+    bool pattern_seed_set = false;
+    UsageMap usage_map;
+    std::vector<std::string> extra_targets;
+    bool bench_mode = false;
+    BenchOptions bench;
+    bool auto_tune_mode = false;
+    bool threads_set = false;
+    bool verify_chunk_set = false;
+    bool queue_depth_set = false;
+    std::string stats_json_path;
+    int stats_fd = -1;
+    unsigned long long max_rate_bytes = 0;
+    unsigned long long max_iops = 0;
+    std::string rate_file_path;
+    std::string io_priority_text;
+    int io_priority = -1;
+    unsigned long long sample_count = 0;
+    size_t sample_block = 64 * 1024;
+    double sample_confidence = 95.0;
+    VerifyOptions verify_options;
+    EraseOptions erase_options;
+    erase_options.generator_threads = std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+    std::string option_value;
+    std::string parse_error;
 
     if (argc < 4) {
         print_help(argv[0]);
@@ -336,6 +5846,275 @@ int main(int argc, char* argv[]) {
             verify_only_mode = true;
         } else if (option == "--quiet-errors" || option == "-q") {
             quiet_errors = true;
+        } else if (option == "--direct") {
+            direct_mode = true;
+        } else if (option == "--skip-holes") {
+            erase_options.skip_holes = true;
+        } else if (option == "--erase-verify") {
+            erase_verify_mode = true;
+        } else if (option == "--metadata-first") {
+            metadata_first_mode = true;
+        } else if (option == "--skip-clean") {
+            erase_options.skip_clean = true;
+        } else if (option == "--auto-tune") {
+            auto_tune_mode = true;
+        } else if (option == "--bench") {
+            bench_mode = true;
+        } else if (match_option_value(option, "--bench-size", argc, argv, arg_index, option_value)) {
+            size_t bench_size = 0;
+            if (!parse_size_mb(option_value.c_str(), "--bench-size", false, bench_size, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            bench.size = bench_size;
+        } else if (match_option_value(option, "--bench-chunks", argc, argv, arg_index, option_value)) {
+            std::vector<unsigned long long> chunk_kb;
+            if (!parse_count_list(option_value, "--bench-chunks", 4, 1024 * 1024, chunk_kb, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            bench.chunk_sizes.clear();
+            for (unsigned long long size_kb : chunk_kb) {
+                bench.chunk_sizes.push_back(static_cast<size_t>(size_kb * 1024));
+            }
+        } else if (match_option_value(option, "--bench-threads", argc, argv, arg_index, option_value)) {
+            std::vector<unsigned long long> thread_counts;
+            if (!parse_count_list(option_value, "--bench-threads", 1, 256, thread_counts, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            bench.threads.assign(thread_counts.begin(), thread_counts.end());
+        } else if (match_option_value(option, "--bench-modes", argc, argv, arg_index, option_value)) {
+            bench.modes.clear();
+            std::stringstream list(option_value);
+            std::string mode;
+            while (std::getline(list, mode, ',')) {
+                if (!is_bench_mode_name(mode)) {
+                    print_error(argv[0], "Unknown benchmark mode: '" + mode + "' (expected sync, sync-direct, io_uring, io_uring-direct or null).", quiet_errors);
+                    return EXIT_INVALID_ARGUMENTS;
+                }
+                bench.modes.push_back(mode);
+            }
+            if (bench.modes.empty()) {
+                print_error(argv[0], "Option --bench-modes requires at least one mode.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        } else if (match_option_value(option, "--bench-format", argc, argv, arg_index, option_value)) {
+            if (option_value != "csv" && option_value != "json") {
+                print_error(argv[0], "Unknown benchmark format: '" + option_value + "' (expected csv or json).", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            bench.format = option_value;
+        } else if (match_option_value(option, "--bench-output", argc, argv, arg_index, option_value)) {
+            if (option_value.empty()) {
+                print_error(argv[0], "Option --bench-output requires a file path.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            bench.output_path = option_value;
+        } else if (match_option_value(option, "--stats-json", argc, argv, arg_index, option_value)) {
+            if (option_value.empty()) {
+                print_error(argv[0], "Option --stats-json requires a file path.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            stats_json_path = option_value;
+        } else if (match_option_value(option, "--stats-fd", argc, argv, arg_index, option_value)) {
+            unsigned long long descriptor = 0;
+            if (!parse_count(option_value, "--stats-fd", 1, INT_MAX, descriptor, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            stats_fd = static_cast<int>(descriptor);
+        } else if (match_option_value(option, "--sample", argc, argv, arg_index, option_value)) {
+            if (!parse_count(option_value, "--sample", 1, 10000000, sample_count, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        } else if (match_option_value(option, "--sample-block", argc, argv, arg_index, option_value)) {
+            unsigned long long block_kb = 0;
+            if (!parse_count(option_value, "--sample-block", 4, 65536, block_kb, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            sample_block = static_cast<size_t>(block_kb * 1024);
+        } else if (match_option_value(option, "--confidence", argc, argv, arg_index, option_value)) {
+            char* end = nullptr;
+            double z_score = 0.0;
+            sample_confidence = std::strtod(option_value.c_str(), &end);
+            if (option_value.empty() || *end != '\0' || !confidence_z_score(sample_confidence, z_score)) {
+                print_error(argv[0], "Option --confidence must be one of 80, 90, 95, 99 or 99.9 (percent).", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        } else if (match_option_value(option, "--sync-window", argc, argv, arg_index, option_value)) {
+            size_t window = 0;
+            if (!parse_size_mb(option_value.c_str(), "--sync-window", false, window, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            erase_options.sync_window = window;
+        } else if (match_option_value(option, "--max-rate", argc, argv, arg_index, option_value)) {
+            size_t rate = 0;
+            if (!parse_size_mb(option_value.c_str(), "--max-rate", false, rate, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            max_rate_bytes = rate;
+        } else if (match_option_value(option, "--max-iops", argc, argv, arg_index, option_value)) {
+            if (!parse_count(option_value, "--max-iops", 1, 10000000, max_iops, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        } else if (match_option_value(option, "--rate-file", argc, argv, arg_index, option_value)) {
+            if (option_value.empty()) {
+                print_error(argv[0], "Option --rate-file requires a file path.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            rate_file_path = option_value;
+        } else if (match_option_value(option, "--ioprio", argc, argv, arg_index, option_value)) {
+            if (!parse_io_priority(option_value, io_priority, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            io_priority_text = option_value;
+        } else if (match_option_value(option, "--pattern", argc, argv, arg_index, option_value)) {
+            pattern_list.clear();
+            if (!parse_pattern_list(option_value, pattern_list, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        } else if (match_option_value(option, "--pattern-seed", argc, argv, arg_index, option_value)) {
+            const bool hex = option_value.rfind("0x", 0) == 0 || option_value.rfind("0X", 0) == 0;
+            const std::string digits = hex ? option_value.substr(2) : option_value;
+            char* end = nullptr;
+            errno = 0;
+            pattern_seed = std::strtoull(digits.c_str(), &end, hex ? 16 : 10);
+            if (digits.empty() || !std::isxdigit(static_cast<unsigned char>(digits[0])) || *end != '\0' || errno == ERANGE) {
+                print_error(argv[0], "Option --pattern-seed requires a 64-bit decimal or 0x-prefixed hex value.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            pattern_seed_set = true;
+        } else if (match_option_value(option, "--passes", argc, argv, arg_index, option_value)) {
+            if (!parse_count(option_value, "--passes", 1, 100, pass_repeats, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        } else if (match_option_value(option, "--gen-threads", argc, argv, arg_index, option_value)) {
+            unsigned long long generator_threads = 0;
+            if (!parse_count(option_value, "--gen-threads", 1, 64, generator_threads, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            erase_options.generator_threads = static_cast<unsigned>(generator_threads);
+        } else if (match_option_value(option, "--target", argc, argv, arg_index, option_value)) {
+            if (option_value.empty()) {
+                print_error(argv[0], "Option --target requires a device or file.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            extra_targets.push_back(option_value);
+        } else if (match_option_value(option, "--journal", argc, argv, arg_index, option_value)) {
+            if (option_value.empty()) {
+                print_error(argv[0], "Option --journal requires a file path.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            journal_path = option_value;
+        } else if (match_option_value(option, "--journal-interval", argc, argv, arg_index, option_value)) {
+            unsigned long long interval = 0;
+            if (!parse_count(option_value, "--journal-interval", 1, 3600, interval, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            journal_interval = static_cast<unsigned>(interval);
+        } else if (option == "--resume") {
+            resume_mode = true;
+        } else if (match_option_value(option, "--map-grain", argc, argv, arg_index, option_value)) {
+            unsigned long long grain_kb = 0;
+            if (!parse_count(option_value, "--map-grain", 4, 1024 * 1024, grain_kb, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            if ((grain_kb & (grain_kb - 1)) != 0) {
+                print_error(argv[0], "Option --map-grain must be a power of two (in KB).", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            usage_map.grain = grain_kb * 1024;
+        } else if (match_option_value(option, "--map", argc, argv, arg_index, option_value)) {
+            if (option_value.empty()) {
+                print_error(argv[0], "Option --map requires a file path.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            map_path = option_value;
+        } else if (match_option_value(option, "--erase-map", argc, argv, arg_index, option_value)) {
+            if (option_value.empty()) {
+                print_error(argv[0], "Option --erase-map requires a file path.", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            erase_map_path = option_value;
+        } else if (match_option_value(option, "--group-inflight", argc, argv, arg_index, option_value)) {
+            unsigned long long inflight = 0;
+            if (!parse_count(option_value, "--group-inflight", 1, 4096, inflight, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            group_inflight = static_cast<unsigned>(inflight);
+        } else if (match_option_value(option, "--threads", argc, argv, arg_index, option_value)) {
+            unsigned long long threads = 0;
+            if (!parse_count(option_value, "--threads", 1, 256, threads, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            verify_options.threads = static_cast<unsigned>(threads);
+            threads_set = true;
+        } else if (match_option_value(option, "--verify-chunk", argc, argv, arg_index, option_value)) {
+            if (!parse_size_mb(option_value.c_str(), "--verify-chunk", false, verify_options.chunk_size, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            verify_chunk_set = true;
+        } else if (match_option_value(option, "--verify-buffers", argc, argv, arg_index, option_value)) {
+            unsigned long long buffer_count = 0;
+            if (!parse_count(option_value, "--verify-buffers", 2, 64, buffer_count, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            verify_options.buffer_count = static_cast<unsigned>(buffer_count);
+        } else if (option == "--offload" || option == "--offload=zeroout") {
+            erase_options.offload = OffloadMode::ZeroOut;
+        } else if (option == "--offload=discard") {
+            erase_options.offload = OffloadMode::Discard;
+        } else if (option == "--offload=secure-discard") {
+            erase_options.offload = OffloadMode::SecureDiscard;
+        } else if (match_option_value(option, "--engine", argc, argv, arg_index, option_value)) {
+            if (option_value == "sync") {
+                erase_options.engine = EraseEngine::Sync;
+            } else if (option_value == "io_uring") {
+                erase_options.engine = EraseEngine::IoUring;
+            } else {
+                print_error(argv[0], "Unknown engine: '" + option_value + "' (expected sync or io_uring).", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        } else if (match_option_value(option, "--writers", argc, argv, arg_index, option_value)) {
+            unsigned long long writers = 0;
+            if (!parse_count(option_value, "--writers", 1, 256, writers, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            erase_options.writers = static_cast<unsigned>(writers);
+        } else if (match_option_value(option, "--writer-layout", argc, argv, arg_index, option_value)) {
+            if (option_value == "interleaved") {
+                erase_options.layout = WriterLayout::Interleaved;
+            } else if (option_value == "contiguous") {
+                erase_options.layout = WriterLayout::Contiguous;
+            } else {
+                print_error(argv[0], "Unknown writer layout: '" + option_value + "' (expected interleaved or contiguous).", quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        } else if (match_option_value(option, "--queue-depth", argc, argv, arg_index, option_value)) {
+            unsigned long long queue_depth = 0;
+            if (!parse_count(option_value, "--queue-depth", 1, 4096, queue_depth, parse_error)) {
+                print_error(argv[0], parse_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            erase_options.queue_depth = static_cast<unsigned>(queue_depth);
+            queue_depth_set = true;
         } else if (option == "--help" || option == "-h") {
             print_help(argv[0]);
             return EXIT_OK;
@@ -348,7 +6127,6 @@ int main(int argc, char* argv[]) {
     const char* device = argv[1];
     size_t erase_size = 0;
     size_t skip_size = 0;
-    std::string parse_error;
 
     if (!parse_size_mb(argv[2], "erase_size_MB", verify_only_mode, erase_size, parse_error)) {
         print_error(argv[0], parse_error, quiet_errors);
@@ -375,31 +6153,314 @@ int main(int argc, char* argv[]) {
         return EXIT_INVALID_ARGUMENTS;
     }
 
+    if (erase_options.offload != OffloadMode::None && (simulate_mode || verify_only_mode)) {
+        print_error(argv[0], "Option --offload cannot be used together with --simulate or --verify-only.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (resume_mode && journal_path.empty()) {
+        print_error(argv[0], "Option --resume requires --journal FILE.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (!journal_path.empty() && (simulate_mode || verify_only_mode)) {
+        print_error(argv[0], "Option --journal cannot be used together with --simulate or --verify-only.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (!map_path.empty() && !verify_only_mode) {
+        print_error(argv[0], "Option --map requires --verify-only.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (sample_count > 0 && (!verify_only_mode || !map_path.empty())) {
+        print_error(argv[0], "Option --sample requires --verify-only and cannot be used together with --map.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (erase_options.sync_window > 0 && (simulate_mode || verify_only_mode)) {
+        print_error(argv[0], "Option --sync-window cannot be used together with --simulate or --verify-only.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (metadata_first_mode && verify_only_mode) {
+        print_error(argv[0], "Option --metadata-first cannot be used together with --verify-only.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (erase_verify_mode && (simulate_mode || verify_only_mode)) {
+        print_error(argv[0], "Option --erase-verify cannot be used together with --simulate or --verify-only.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    // Przebiegi: lista wzorców powtórzona --passes razy (domyślnie jeden przebieg zerami)
+    if (pattern_list.empty()) {
+        pattern_list.push_back(PassPattern{});
+    }
+    std::vector<PassPattern> passes;
+    for (unsigned long long repeat = 0; repeat < pass_repeats; ++repeat) {
+        passes.insert(passes.end(), pattern_list.begin(), pattern_list.end());
+    }
+    if (!pattern_seed_set) {
+        pattern_seed = random_pattern_seed();
+    }
+    for (size_t pass_index = 0; pass_index < passes.size(); ++pass_index) {
+        seed_pattern(passes[pass_index], pattern_seed, pass_index);
+    }
+    const bool pattern_mode = passes.size() > 1 || passes[0].kind != PatternKind::Zero;
+    const bool seeded_passes = std::any_of(passes.begin(), passes.end(), [](const PassPattern& pass) {
+        return pass.kind == PatternKind::Random || pass.kind == PatternKind::CryptoRandom;
+    });
+
+    if (pattern_mode && !journal_path.empty()) {
+        print_error(argv[0], "Options --pattern and --passes cannot be used together with --journal.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    // Weryfikacja wzorca po zakończeniu programu: cel ma zawierać ostatni przebieg, odtworzony z tego samego
+    // --pattern/--passes/--pattern-seed; pominięte fragmenty i dziury zawierają co innego, więc nie są obsługiwane
+    if (pattern_mode && verify_only_mode) {
+        const PatternKind last_kind = passes.back().kind;
+        if ((last_kind == PatternKind::Random || last_kind == PatternKind::CryptoRandom) && !pattern_seed_set) {
+            print_error(argv[0], "Option --verify-only with random or crypto passes requires --pattern-seed (printed by the erase run).", quiet_errors);
+            return EXIT_INVALID_ARGUMENTS;
+        }
+        if (skip_size != 0 || sample_count > 0 || !map_path.empty()) {
+            print_error(argv[0], "Option --verify-only with --pattern requires skip_size_MB 0 and cannot be used with --sample or --map.", quiet_errors);
+            return EXIT_INVALID_ARGUMENTS;
+        }
+    }
+
+    if (erase_options.skip_clean && (verify_only_mode || pattern_mode)) {
+        print_error(argv[0], "Option --skip-clean cannot be used together with --verify-only, --pattern or --passes.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (erase_options.skip_clean && erase_options.engine == EraseEngine::IoUring) {
+        print_error(argv[0], "Option --skip-clean cannot be used together with --engine=io_uring.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+    erase_options.scan_chunk_size = verify_options.chunk_size;
+    erase_options.scan_buffers = verify_options.buffer_count;
+
+    if (!erase_map_path.empty() && verify_only_mode) {
+        print_error(argv[0], "Option --erase-map cannot be used together with --verify-only.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (erase_options.offload != OffloadMode::None && erase_options.engine == EraseEngine::IoUring) {
+        print_error(argv[0], "Option --offload cannot be used together with --engine=io_uring.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    if (erase_options.writers > 1 && (verify_only_mode || pattern_mode || erase_options.skip_clean
+                                      || erase_options.offload != OffloadMode::None || erase_options.engine == EraseEngine::IoUring)) {
+        print_error(argv[0], "Option --writers cannot be used together with --verify-only, --pattern, --passes, --skip-clean, --offload or --engine=io_uring.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    const bool telemetry_mode = !stats_json_path.empty() || stats_fd >= 0;
+    const bool throttle_mode = max_rate_bytes > 0 || max_iops > 0 || !rate_file_path.empty();
+    if (!stats_json_path.empty() && stats_fd >= 0) {
+        print_error(argv[0], "Use either --stats-json or --stats-fd, not both.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
+    // Pomiar wydajności na pliku/urządzeniu testowym zamiast kasowania
+    if (bench_mode) {
+        if (simulate_mode || verify_zero_mode || verify_only_mode || erase_verify_mode || pattern_mode || erase_options.skip_clean
+            || erase_options.skip_holes || erase_options.offload != OffloadMode::None || !journal_path.empty() || !map_path.empty()
+            || !erase_map_path.empty() || !extra_targets.empty() || device[0] == '@' || auto_tune_mode || telemetry_mode
+            || throttle_mode || erase_options.sync_window > 0 || metadata_first_mode || erase_options.writers > 1) {
+            print_error(argv[0], "Option --bench cannot be combined with other modes or several targets.", quiet_errors);
+            return EXIT_INVALID_ARGUMENTS;
+        }
+        if (bench.chunk_sizes.empty()) {
+            bench.chunk_sizes.push_back(erase_size);
+        }
+        if (bench.threads.empty()) {
+            bench.threads.push_back(verify_options.threads);
+        }
+
+        signal(SIGINT, handle_signal);
+        return run_benchmark(device, skip_size, bench, erase_options.queue_depth, verify_options.buffer_count);
+    }
+
+    // Lista celów: "@plik" to manifest, --target dodaje kolejne urządzenia
+    std::vector<std::string> devices;
+    const bool manifest_mode = device[0] == '@';
+    if (manifest_mode) {
+        if (!read_target_manifest(device + 1, devices, parse_error)) {
+            print_error(argv[0], parse_error, quiet_errors);
+            return EXIT_INVALID_ARGUMENTS;
+        }
+    } else {
+        devices.push_back(device);
+    }
+    devices.insert(devices.end(), extra_targets.begin(), extra_targets.end());
+
+    // Ten sam cel pod inną ścieżką (/dev/sdb i /dev/disk/by-id/..., dowiązanie w manifeście) rozpoznawany po
+    // st_rdev urządzenia blokowego albo st_dev/st_ino pliku; bez stat() zostaje porównanie ścieżek
+    struct TargetKey {
+        bool resolved = false;
+        bool block = false;
+        dev_t device = 0;
+        ino_t inode = 0;
+    };
+    std::vector<TargetKey> target_keys(devices.size());
+    for (size_t index = 0; index < devices.size(); ++index) {
+        struct stat target_stat {};
+        TargetKey& key = target_keys[index];
+        if (stat(devices[index].c_str(), &target_stat) == 0) {
+            key.resolved = true;
+            key.block = S_ISBLK(target_stat.st_mode);
+            key.device = key.block ? target_stat.st_rdev : target_stat.st_dev;
+            key.inode = key.block ? 0 : target_stat.st_ino;
+        }
+
+        for (size_t previous = 0; previous < index; ++previous) {
+            const TargetKey& other = target_keys[previous];
+            const bool same = key.resolved && other.resolved
+                ? key.block == other.block && key.device == other.device && key.inode == other.inode
+                : devices[previous] == devices[index];
+            if (same) {
+                const std::string alias = devices[previous] == devices[index] ? "" : " (same target as " + devices[previous] + ")";
+                print_error(argv[0], "Target listed more than once: " + devices[index] + alias, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+        }
+    }
+
+    const bool batch_mode = manifest_mode || devices.size() > 1;
+    if (batch_mode && (verify_zero_mode || verify_only_mode || erase_verify_mode || pattern_mode || !journal_path.empty() || !erase_map_path.empty()
+                       || auto_tune_mode || telemetry_mode || metadata_first_mode)) {
+        print_error(argv[0], "Options --verify-zero, --verify-only, --erase-verify, --pattern, --passes, --journal, --erase-map, --auto-tune, --stats-json, --stats-fd and --metadata-first work with a single target only.", quiet_errors);
+        return EXIT_INVALID_ARGUMENTS;
+    }
+
     signal(SIGINT, handle_signal); // Obsługa Ctrl+C
 
-    int fd = open(device, (simulate_mode || verify_only_mode) ? O_RDONLY : O_RDWR);
-    if (fd < 0) {
-        perror("Error opening device");
-        return EXIT_OPEN_FAILED;
+    // Priorytet ustawiany przed startem wątków roboczych, które go dziedziczą
+    if (io_priority >= 0 && syscall(SYS_ioprio_set, 1 /* IOPRIO_WHO_PROCESS */, 0, io_priority) != 0) {
+        std::cerr << "Warning: could not set I/O priority " << io_priority_text << " (" << std::strerror(errno) << ")." << std::endl;
+        io_priority = -1;
     }
 
-    // Pobranie rozmiaru dysku
+    // Jeden ogranicznik na cały proces: limit obejmuje zapisy i odczyty wszystkich celów
+    RateLimiter throttle;
+    std::unique_ptr<RateControlFile> rate_control;
+    if (throttle_mode) {
+        throttle.set_limits(max_rate_bytes, max_iops);
+        if (!rate_file_path.empty()) {
+            rate_control.reset(new RateControlFile(rate_file_path, throttle));
+            std::string rate_error;
+            rate_control->reload(rate_error);
+            if (!rate_error.empty()) {
+                print_error(argv[0], rate_error, quiet_errors);
+                return EXIT_INVALID_ARGUMENTS;
+            }
+            rate_control->start();
+        }
+        erase_options.throttle = &throttle;
+        verify_options.throttle = &throttle;
+    }
+    auto print_throttle_info = [&]() {
+        if (throttle_mode) {
+            std::cout << "Throttle: " << describe_rate_limits(throttle)
+                      << (rate_file_path.empty() ? std::string("") : " (control file " + rate_file_path + ")") << std::endl;
+        }
+        if (io_priority >= 0) {
+            std::cout << "I/O priority: " << io_priority_text << std::endl;
+        }
+    };
+
+    if (batch_mode) {
+        erase_options.simulate = simulate_mode;
+        print_throttle_info();
+        return run_batch_erase(devices, erase_size, skip_size, erase_options, direct_mode, group_inflight);
+    }
+
+    // Strumień telemetrii; liczniki i histogramy są podpinane pod pętle I/O dopiero przy starcie operacji
+    std::unique_ptr<TelemetryStream> telemetry;
+    if (telemetry_mode) {
+        telemetry.reset(new TelemetryStream());
+        std::string stats_error;
+        if (!telemetry->open_output(stats_json_path, stats_fd, stats_error)) {
+            print_error(argv[0], stats_error, quiet_errors);
+            return EXIT_INVALID_ARGUMENTS;
+        }
+    }
+    auto finish_telemetry = [&telemetry](int exit_code, const VerificationStats* stats = nullptr) {
+        if (telemetry != nullptr) {
+            telemetry->finish(exit_code, stats);
+        }
+        return exit_code;
+    };
+
+    int fd = -1;
     unsigned long long device_size = 0;
-    if (ioctl(fd, BLKGETSIZE64, &device_size) < 0) {
-        struct stat st {};
-        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
-            device_size = static_cast<unsigned long long>(st.st_size);
-        } else {
-            perror("Error getting device size");
-            close(fd);
-            return EXIT_SIZE_FAILED;
+    const int open_result = open_target(device, simulate_mode || verify_only_mode, direct_mode, fd, device_size);
+    if (open_result != EXIT_OK) {
+        return open_result;
+    }
+
+    if (direct_mode) {
+        const size_t alignment = get_direct_io_alignment(fd);
+        erase_options.direct_alignment = alignment;
+        verify_options.direct_alignment = alignment;
+        if (sample_block % alignment != 0) {
+            sample_block += alignment - sample_block % alignment;
         }
     }
 
-    if (device_size == 0) {
-        std::cerr << "Error: target size is 0 bytes." << std::endl;
+    // Telemetria startuje zaraz po otwarciu celu, więc odliczanie, wstępna weryfikacja (--verify-zero) i każdy
+    // wcześniejszy błąd też kończą się zdarzeniem summary
+    EraseProgress run_progress;
+    if (telemetry != nullptr) {
+        erase_options.write_latency = &telemetry->write_latency;
+        erase_options.read_latency = &telemetry->read_latency;
+        erase_options.error_log = &telemetry->errors;
+        verify_options.progress = &run_progress;
+        verify_options.read_latency = &telemetry->read_latency;
+        verify_options.error_log = &telemetry->errors;
+        const char* operation = verify_only_mode ? (sample_count > 0 ? "sample" : "verify") : (simulate_mode ? "simulate" : "erase");
+        const unsigned long long total = verify_only_mode && sample_count > 0
+            ? std::min<unsigned long long>(device_size, sample_count * sample_block) : device_size;
+        telemetry->start(operation, device, total, run_progress);
+    }
+
+    if (direct_mode && (erase_size % erase_options.direct_alignment != 0 || skip_size % erase_options.direct_alignment != 0)) {
+        print_error(argv[0], "Option --direct requires erase/skip sizes aligned to " + std::to_string(erase_options.direct_alignment) + " bytes.", quiet_errors);
         close(fd);
-        return EXIT_SIZE_FAILED;
+        return finish_telemetry(EXIT_INVALID_ARGUMENTS);
+    }
+
+    const bool block_device = is_block_device(fd);
+    erase_options.offload = resolve_offload_mode(erase_options.offload, device, block_device);
+
+    // Rozmiary I/O z próby zastępują domyślne; wartości podane jawnie (--threads, --verify-chunk, --queue-depth) zostają
+    AutoTuneResult tune;
+    if (auto_tune_mode) {
+        std::cout << "Auto-tune: probing target (read-only)..." << std::endl;
+        std::string tune_error;
+        // Nieudana próba nie przerywa kasowania: zostają domyślne rozmiary I/O
+        if (!auto_tune_target(device, fd, device_size, tune, tune_error)) {
+            std::cerr << "Warning: " << tune_error << " Keeping default I/O sizes." << std::endl;
+            auto_tune_mode = false;
+        }
+    }
+    if (auto_tune_mode) {
+        erase_options.io_size = erase_options.engine == EraseEngine::IoUring ? tune.request_size : tune.erase_io_size;
+        if (!queue_depth_set) {
+            erase_options.queue_depth = tune.depth;
+        }
+        if (!verify_chunk_set) {
+            verify_options.chunk_size = tune.verify_io_size;
+        }
+        if (!threads_set) {
+            verify_options.threads = tune.depth;
+        }
+        erase_options.scan_chunk_size = verify_options.chunk_size;
     }
 
     // Pobranie informacji o dysku
@@ -411,21 +6472,213 @@ int main(int argc, char* argv[]) {
     std::cout << "Size: " << device_size / (1024 * 1024) << " MB" << std::endl;
     std::cout << "Type: " << disk_type << std::endl;
     std::cout << "Model: " << disk_info << std::endl;
+    if (direct_mode) {
+        std::cout << "I/O: direct (O_DIRECT, alignment " << verify_options.direct_alignment << " bytes)" << std::endl;
+    }
+    print_throttle_info();
+    if (auto_tune_mode) {
+        auto limit_text = [](unsigned long long bytes) { return bytes > 0 ? format_bytes(bytes) : std::string("unknown"); };
+        std::cout << "Auto-tune limits: io_min " << limit_text(tune.io_min) << ", io_opt " << limit_text(tune.io_opt)
+                  << ", max request " << limit_text(tune.max_request)
+                  << ", nr_requests " << (tune.nr_requests > 0 ? std::to_string(tune.nr_requests) : std::string("unknown"))
+                  << ", rotational " << (tune.rotational < 0 ? "unknown" : (tune.rotational == 1 ? "yes" : "no")) << std::endl;
+        std::cout << "Auto-tune probe: " << format_bytes(tune.request_size) << " reads x " << tune.depth << " in flight -> "
+                  << std::fixed << std::setprecision(2) << tune.probe_mb_s << " MB/s" << (tune.probe_direct ? " (O_DIRECT)" : " (page cache dropped)") << std::endl;
+        if (!verify_only_mode) {
+            std::cout << "Auto-tune erase: " << format_bytes(erase_options.io_size) << " per write"
+                      << (erase_options.engine == EraseEngine::IoUring ? ", queue depth " + std::to_string(erase_options.queue_depth) : std::string(""))
+                      << " (erase/skip geometry unchanged)" << std::endl;
+        }
+        std::cout << "Auto-tune verify: " << format_bytes(verify_options.chunk_size) << " per read, "
+                  << verify_options.threads << " thread(s)" << std::endl;
+    }
     if (verify_only_mode) {
         std::cout << "Mode: VERIFY ONLY" << std::endl;
+        if (pattern_mode && passes.back().kind != PatternKind::Zero) {
+            // Bajty !00 w raporcie to bajty niezgodne z ostatnim przebiegiem
+            verify_options.expected_pattern = &passes.back();
+            std::cout << "Expected pattern: " << passes.back().name() << " (pass " << passes.size() << "/" << passes.size();
+            if (seeded_passes) {
+                std::cout << ", seed 0x" << std::hex << pattern_seed << std::dec;
+            }
+            std::cout << "); non-zero bytes below are mismatches" << std::endl;
+        }
     } else {
         std::cout << "Mode: " << (simulate_mode ? "SIMULATION (no write)" : "ERASE") << std::endl;
+        if (erase_options.offload != OffloadMode::None) {
+            std::cout << "Engine: offload (" << offload_mode_name(erase_options.offload, block_device)
+                      << ", write fallback)" << std::endl;
+        } else if (erase_options.engine == EraseEngine::IoUring) {
+            std::cout << "Engine: io_uring (queue depth " << erase_options.queue_depth << ")" << std::endl;
+        } else if (erase_options.writers > 1) {
+            std::cout << "Engine: sync, " << erase_options.writers << " writer threads ("
+                      << (erase_options.layout == WriterLayout::Contiguous ? "contiguous ranges" : "interleaved chunks") << ")" << std::endl;
+        } else {
+            std::cout << "Engine: sync" << std::endl;
+        }
+        if (erase_options.sync_window > 0) {
+            std::cout << "Writeback: sync_file_range every " << format_bytes(erase_options.sync_window)
+                      << " (at most two windows dirty), fdatasync before completion" << std::endl;
+        }
+        if (erase_options.skip_clean) {
+            std::cout << "Skip clean: read-ahead scan in " << format_bytes(erase_options.scan_chunk_size)
+                      << " chunks, zero scan " << active_zero_scanner().name << ", only dirty chunks are written" << std::endl;
+        }
+        if (pattern_mode) {
+            std::cout << "Passes: ";
+            for (size_t pass_index = 0; pass_index < passes.size(); ++pass_index) {
+                std::cout << (pass_index == 0 ? "" : ", ") << passes[pass_index].name();
+            }
+            std::cout << " (" << erase_options.generator_threads << " generator threads)" << std::endl;
+            if (seeded_passes) {
+                std::cout << "Pattern seed: 0x" << std::hex << pattern_seed << std::dec
+                          << " (verify later with --verify-only --pattern-seed)" << std::endl;
+            }
+        }
+    }
+
+    ErasureJournal journal_state;
+    journal_state.device = device;
+    journal_state.identity = disk_info;
+    journal_state.unique_id = get_target_unique_id(fd);
+    journal_state.device_size = device_size;
+    journal_state.erase_size = erase_size;
+    journal_state.skip_size = skip_size;
+
+    if (resume_mode) {
+        ErasureJournal saved_journal;
+        std::string journal_error;
+        if (!read_erasure_journal(journal_path, saved_journal, journal_error)) {
+            print_error(argv[0], journal_error, quiet_errors);
+            close(fd);
+            return finish_telemetry(EXIT_INVALID_ARGUMENTS);
+        }
+
+        // Sam model i rozmiar nie odróżniają dwóch egzemplarzy tego samego dysku; bez identyfikatora pominięcie
+        // początku mogłoby zostawić dane na innym nośniku
+        if (saved_journal.unique_id.empty() || journal_state.unique_id.empty()) {
+            print_error(argv[0], "Cannot resume: no unique identifier (serial, WWID, device number or inode) for the journal or this target.", quiet_errors);
+            close(fd);
+            return finish_telemetry(EXIT_INVALID_ARGUMENTS);
+        }
+
+        if (saved_journal.unique_id != journal_state.unique_id
+            || saved_journal.identity != disk_info || saved_journal.device_size != device_size
+            || saved_journal.erase_size != erase_size || saved_journal.skip_size != skip_size) {
+            print_error(argv[0], "Journal does not match this target (unique identifier, identity, size) or erase/skip geometry.", quiet_errors);
+            close(fd);
+            return finish_telemetry(EXIT_INVALID_ARGUMENTS);
+        }
+
+        if (saved_journal.device != device) {
+            std::cerr << "Warning: journal was written for " << saved_journal.device << ", resuming on " << device << "." << std::endl;
+        }
+
+        if (saved_journal.complete) {
+            std::cout << "Journal reports that erasure of this target is already complete." << std::endl;
+            close(fd);
+            return finish_telemetry(EXIT_OK);
+        }
+
+        // Zaokrąglenie w dół do 1 MB zachowuje wyrównanie wymagane przez O_DIRECT
+        erase_options.start_offset = std::min(saved_journal.offset, device_size);
+        erase_options.start_offset -= erase_options.start_offset % (1024 * 1024);
+        journal_state.offset = erase_options.start_offset;
+        std::cout << "Resuming from offset: " << erase_options.start_offset << " bytes ("
+                  << std::fixed << std::setprecision(2) << (erase_options.start_offset * 100.0) / device_size << "%)" << std::endl;
+    }
+
+    std::vector<DataExtent> dirty_extents;
+    if (!erase_map_path.empty()) {
+        unsigned long long map_size = 0;
+        std::string map_error;
+        if (!read_usage_map(erase_map_path, map_size, dirty_extents, map_error)) {
+            print_error(argv[0], map_error, quiet_errors);
+            close(fd);
+            return finish_telemetry(EXIT_INVALID_ARGUMENTS);
+        }
+
+        if (map_size != device_size) {
+            print_error(argv[0], "Map was created for a target of different size.", quiet_errors);
+            close(fd);
+            return finish_telemetry(EXIT_INVALID_ARGUMENTS);
+        }
+
+        unsigned long long dirty_bytes = 0;
+        for (const DataExtent& extent : dirty_extents) {
+            dirty_bytes += extent.length;
+        }
+        erase_options.data_extents = &dirty_extents;
+        std::cout << "Erase map: " << erase_map_path << " (" << dirty_extents.size() << " extents, "
+                  << format_bytes(dirty_bytes) << " to erase)" << std::endl;
+    }
+
+    // Obszary metadanych są wykrywane przed odliczaniem, żeby operator widział, co zostanie zniszczone najpierw
+    std::vector<MetadataRegion> metadata_regions;
+    unsigned long long metadata_bytes = 0;
+    if (metadata_first_mode) {
+        std::string detect_error;
+        if (!detect_metadata_regions(device, device_size, metadata_regions, detect_error)) {
+            print_error(argv[0], detect_error, quiet_errors);
+            close(fd);
+            return finish_telemetry(EXIT_OPEN_FAILED);
+        }
+        for (const MetadataRegion& region : metadata_regions) {
+            metadata_bytes += region.length;
+        }
+        std::cout << "Metadata first: " << metadata_regions.size() << " region(s), " << format_bytes(metadata_bytes)
+                  << " zeroed before the erase/skip sweep" << std::endl;
+        print_metadata_regions(metadata_regions);
+    }
+
+    if (verify_only_mode || verify_zero_mode) {
+        std::cout << "Zero scan: " << active_zero_scanner().name;
+        if (verify_options.threads > 1) {
+            std::cout << " (" << verify_options.threads << " threads)";
+        }
+        std::cout << std::endl;
+    }
+
+    if (verify_only_mode && sample_count > 0) {
+        std::cout << "Sampling " << sample_count << " random blocks of " << format_bytes(sample_block)
+                  << " (sorted by offset, " << verify_options.threads << " thread(s))..." << std::endl;
+        VerificationStats verify_stats;
+        SampleEstimate estimate;
+        std::string verify_error;
+
+        // Postęp tekstowy nie miesza się ze strumieniem telemetrii (np. --stats-fd 1)
+        if (!verify_target_sample(fd, device_size, verify_options, sample_count, sample_block, sample_confidence,
+                                  telemetry == nullptr, verify_stats, estimate, verify_error)) {
+            print_error(argv[0], verify_error, quiet_errors);
+            close(fd);
+            return finish_telemetry(EXIT_SIZE_FAILED);
+        }
+        close(fd);
+        std::cout << std::endl;
+
+        if (!keep_running) {
+            std::cout << "Verification interrupted by user." << std::endl;
+            return finish_telemetry(EXIT_USER_ABORTED, &verify_stats);
+        }
+
+        // Raport dotyczy przeczytanych bloków, oszacowanie – całego celu
+        print_verification_report(verify_stats.bytes_read, verify_stats);
+        print_sample_estimate(device_size, estimate);
+        return finish_telemetry(EXIT_OK, &verify_stats);
     }
 
     if (verify_only_mode) {
         std::cout << "Verifying full target content and generating report..." << std::endl;
         VerificationStats verify_stats;
         std::string verify_error;
+        if (!map_path.empty()) {
+            verify_options.usage_map = &usage_map;
+        }
 
-        if (!verify_target_content(fd, device_size, false, true, verify_stats, verify_error)) {
+        if (!verify_target_content(fd, device_size, verify_options, false, true, verify_stats, verify_error)) {
             print_error(argv[0], verify_error, quiet_errors);
             close(fd);
-            return EXIT_SIZE_FAILED;
+            return finish_telemetry(EXIT_SIZE_FAILED);
         }
 
         std::cout << std::endl;
@@ -433,12 +6686,22 @@ int main(int argc, char* argv[]) {
         if (!keep_running) {
             std::cout << "Verification interrupted by user." << std::endl;
             close(fd);
-            return EXIT_USER_ABORTED;
+            return finish_telemetry(EXIT_USER_ABORTED, &verify_stats);
         }
 
         print_verification_report(device_size, verify_stats);
         close(fd);
-        return EXIT_OK;
+
+        if (!map_path.empty()) {
+            print_density_heatmap(device_size, usage_map);
+            std::string map_error;
+            if (!write_usage_map(map_path, device, device_size, verify_stats, usage_map, map_error)) {
+                print_error(argv[0], map_error, quiet_errors);
+                return finish_telemetry(EXIT_WRITE_FAILED, &verify_stats);
+            }
+            std::cout << "  Map written to: " << map_path << std::endl;
+        }
+        return finish_telemetry(EXIT_OK, &verify_stats);
     }
 
     if (verify_zero_mode) {
@@ -446,10 +6709,10 @@ int main(int argc, char* argv[]) {
         VerificationStats verify_stats;
         std::string verify_error;
 
-        if (!verify_target_content(fd, device_size, true, false, verify_stats, verify_error)) {
+        if (!verify_target_content(fd, device_size, verify_options, true, false, verify_stats, verify_error)) {
             print_error(argv[0], verify_error, quiet_errors);
             close(fd);
-            return EXIT_SIZE_FAILED;
+            return finish_telemetry(EXIT_SIZE_FAILED);
         }
 
         if (verify_stats.first_non_zero_offset != std::numeric_limits<unsigned long long>::max()) {
@@ -457,7 +6720,7 @@ int main(int argc, char* argv[]) {
             if (!ask_user_to_continue()) {
                 std::cout << "Operation cancelled by user." << std::endl;
                 close(fd);
-                return EXIT_USER_ABORTED;
+                return finish_telemetry(EXIT_USER_ABORTED);
             }
         } else {
             std::cout << "Verification result: target already contains only 00 bytes." << std::endl;
@@ -468,71 +6731,118 @@ int main(int argc, char* argv[]) {
     countdown();
     if (!keep_running) {
         close(fd);
-        return 0;
+        return finish_telemetry(EXIT_OK);
     }
 
-    // Bufor do kasowania
-    char* buffer = nullptr;
-    if (!simulate_mode) {
-        buffer = new char[erase_size];
-        memset(buffer, 0, erase_size);
+    // Liczniki wstępnej weryfikacji nie przechodzą do kasowania; odczyty --erase-verify nie publikują postępu
+    erase_options.simulate = simulate_mode;
+    EraseProgress& erase_progress = run_progress;
+    erase_progress.processed_bytes = 0;
+    erase_progress.completed_offset = erase_options.start_offset;
+    verify_options.progress = nullptr;
+    if (telemetry != nullptr) {
+        erase_options.progress = &erase_progress;
+        telemetry->restart_timing();
     }
-
-    unsigned long long total_erased = 0;
-    auto start_time = std::chrono::high_resolution_clock::now();
-
-    for (unsigned long long offset = 0; offset < device_size && keep_running; offset += (erase_size + skip_size)) {
-        if (lseek(fd, offset, SEEK_SET) < 0) {
-            perror("Error seeking device");
-            delete[] buffer;
+    std::unique_ptr<JournalWriter> journal;
+    if (!journal_path.empty()) {
+        std::string journal_error;
+        if (!write_erasure_journal(journal_path, journal_state, journal_error)) {
+            print_error(argv[0], journal_error, quiet_errors);
             close(fd);
-            return EXIT_SEEK_FAILED;
+            return finish_telemetry(EXIT_WRITE_FAILED);
         }
 
-        const size_t bytes_to_write = std::min<unsigned long long>(erase_size, device_size - offset);
+        erase_options.progress = &erase_progress;
+        journal.reset(new JournalWriter(journal_path, journal_state, fd, erase_progress, journal_interval));
+        std::cout << "Journal: " << journal_path << " (checkpoint every " << journal_interval << " s)" << std::endl;
+    }
 
+    // Metadane giną w pierwszych sekundach; przerwany później przebieg zostawia cel już bezużyteczny
+    double metadata_seconds = 0.0;
+    if (metadata_first_mode && keep_running) {
         if (!simulate_mode) {
-            size_t bytes_written = 0;
-
-            while (bytes_written < bytes_to_write) {
-                ssize_t write_result = write(fd, buffer + bytes_written, bytes_to_write - bytes_written);
-                if (write_result < 0) {
-                    perror("Error writing to device");
-                    delete[] buffer;
-                    close(fd);
-                    return EXIT_WRITE_FAILED;
+            const int metadata_result = erase_metadata_regions(fd, metadata_regions, erase_options, metadata_seconds);
+            if (metadata_result != EXIT_OK) {
+                if (journal != nullptr) {
+                    journal->finish(false);
                 }
+                close(fd);
+                return finish_telemetry(metadata_result);
+            }
+        }
+        std::cout << (simulate_mode ? "Metadata regions (not written in simulation): " : "Metadata regions zeroed and synced: ")
+                  << format_bytes(metadata_bytes) << " in " << std::fixed << std::setprecision(2) << metadata_seconds << " s" << std::endl;
+    }
 
-                if (write_result == 0) {
-                    std::cerr << "Error: no data written to device." << std::endl;
-                    delete[] buffer;
-                    close(fd);
-                    return EXIT_WRITE_FAILED;
-                }
+    // Każdy przebieg to pełne kasowanie swoim wzorcem; --erase-verify sprawdza każdy z nich osobno
+    EraseStats erase_stats;
+    std::vector<std::unique_ptr<ReadBackVerifier>> read_backs;
+    int erase_result = EXIT_OK;
+    unsigned long long passes_bytes = 0;
+    double passes_duration = 0.0;
+    for (size_t pass_index = 0; pass_index < passes.size() && keep_running; ++pass_index) {
+        const PassPattern& pass = passes[pass_index];
+        erase_options.pattern = &pass;
+        if (passes.size() > 1) {
+            std::cout << "\nPass " << pass_index + 1 << "/" << passes.size() << ": " << pass.name() << std::endl;
+        }
 
-                bytes_written += static_cast<size_t>(write_result);
+        if (erase_verify_mode) {
+            std::string read_back_error;
+            verify_options.expected_pattern = pass.kind == PatternKind::Zero ? nullptr : &pass;
+            read_backs.emplace_back(new ReadBackVerifier(device_size, erase_size, skip_size, erase_options, erase_progress, verify_options));
+            if (!read_backs.back()->start(device, read_back_error)) {
+                print_error(argv[0], read_back_error, quiet_errors);
+                close(fd);
+                return finish_telemetry(EXIT_OPEN_FAILED);
+            }
+            erase_options.progress = &erase_progress;
+            if (pass_index == 0) {
+                std::cout << "Read-back: pipelined" << (read_backs.back()->direct_alignment > 0 ? " (O_DIRECT)" : "")
+                          << ", zero scan " << active_zero_scanner().name << std::endl;
             }
         }
 
-        total_erased += bytes_to_write;
-
-        auto current_time = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = current_time - start_time;
-        const unsigned long long processed_bytes = std::min<unsigned long long>(offset + erase_size + skip_size, device_size);
-        double percentage = (double)processed_bytes / device_size * 100.0;
-        double erased_percentage = (double)total_erased / device_size * 100.0;
-        double speed = elapsed.count() > 0.0 ? (total_erased / (1024.0 * 1024.0)) / elapsed.count() : 0.0;
+        erase_result = erase_target(fd, device_size, erase_size, skip_size, erase_options, erase_stats);
+        if (erase_verify_mode) {
+            read_backs.back()->finish();
+        }
+        passes_bytes += erase_stats.total_erased - erase_stats.resumed_bytes;
+        passes_duration += erase_stats.duration_seconds;
+        if (erase_result != EXIT_OK) {
+            break;
+        }
 
-        print_progress(percentage, speed, erased_percentage);
+        // Kolejny przebieg zaczyna od początku nośnika
+        if (pass_index + 1 < passes.size()) {
+            if (keep_running) {
+                std::cout << "\nPass " << pass_index + 1 << "/" << passes.size() << " done in "
+                          << std::fixed << std::setprecision(2) << erase_stats.duration_seconds << " s" << std::endl;
+            }
+            erase_options.start_offset = 0;
+            erase_progress.completed_offset = 0;
+            erase_progress.processed_bytes = 0;
+            erase_progress.erased_bytes = 0;
+        }
+    }
 
-        if (simulate_mode) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (journal != nullptr) {
+        if (!journal->finish(erase_result == EXIT_OK && keep_running)) {
+            std::cerr << "\nWarning: " << journal->last_error << std::endl;
+        } else if (!journal->state.complete) {
+            std::cout << "\nJournal checkpoint saved at offset " << journal->state.offset
+                      << " bytes; rerun with --resume to continue." << std::endl;
         }
     }
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> total_time = end_time - start_time;
-    double avg_speed = total_time.count() > 0.0 ? (total_erased / (1024.0 * 1024.0)) / total_time.count() : 0.0;
+    if (erase_result != EXIT_OK) {
+        close(fd);
+        return finish_telemetry(erase_result);
+    }
+
+    const unsigned long long total_erased = erase_stats.total_erased;
+    double avg_speed = passes_duration > 0.0 ? (passes_bytes / (1024.0 * 1024.0)) / passes_duration : 0.0;
     const double erased_percentage = device_size > 0 ? (total_erased * 100.0) / device_size : 0.0;
 
     if (keep_running) {
@@ -548,12 +6858,73 @@ int main(int argc, char* argv[]) {
     std::cout << "Erased data: " << format_bytes(total_erased)
               << " (" << total_erased << " bytes, "
               << std::fixed << std::setprecision(2) << erased_percentage << "%)" << std::endl;
-    std::cout << "Total time: " << total_time.count() << " seconds" << std::endl;
+    if (erase_stats.resumed_bytes > 0) {
+        std::cout << "  Erased in previous runs: " << format_bytes(erase_stats.resumed_bytes)
+                  << " (" << erase_stats.resumed_bytes << " bytes)" << std::endl;
+    }
+    if (erase_options.offload != OffloadMode::None) {
+        std::cout << "  Offloaded (" << offload_mode_name(erase_options.offload, block_device) << "): "
+                  << format_bytes(erase_stats.offloaded_bytes) << " (" << erase_stats.offloaded_bytes << " bytes)" << std::endl;
+        std::cout << "  Written (write fallback): " << format_bytes(erase_stats.written_bytes)
+                  << " (" << erase_stats.written_bytes << " bytes)" << std::endl;
+    }
+    if (erase_options.data_extents != nullptr) {
+        std::cout << "  Skipped clean ranges (per map): " << format_bytes(erase_stats.skipped_bytes)
+                  << " (" << erase_stats.skipped_bytes << " bytes)" << std::endl;
+    } else if (erase_options.skip_holes) {
+        std::cout << "  Skipped holes (already 00): " << format_bytes(erase_stats.skipped_bytes)
+                  << " (" << erase_stats.skipped_bytes << " bytes)" << std::endl;
+    }
+    if (erase_options.skip_clean) {
+        const unsigned long long dirty_bytes = erase_stats.scanned_bytes - erase_stats.clean_bytes;
+        std::cout << "  Scanned: " << format_bytes(erase_stats.scanned_bytes)
+                  << " (" << erase_stats.scanned_bytes << " bytes)" << std::endl;
+        std::cout << "  Found clean (already 00): " << format_bytes(erase_stats.clean_bytes)
+                  << " (" << erase_stats.clean_bytes << " bytes)" << std::endl;
+        std::cout << (simulate_mode ? "  Dirty (would be written): " : "  Dirty (written): ") << format_bytes(dirty_bytes)
+                  << " (" << dirty_bytes << " bytes)" << std::endl;
+    }
+    if (metadata_first_mode) {
+        std::cout << "Prioritized metadata: " << metadata_regions.size() << " region(s), " << format_bytes(metadata_bytes)
+                  << (simulate_mode ? " (not written)" : " zeroed first") << " in " << metadata_seconds
+                  << " seconds (not included in total time)" << std::endl;
+        print_metadata_regions(metadata_regions);
+    }
+    if (passes.size() > 1) {
+        std::cout << "Passes: " << passes.size() << " (";
+        for (size_t pass_index = 0; pass_index < passes.size(); ++pass_index) {
+            std::cout << (pass_index == 0 ? "" : ", ") << passes[pass_index].name();
+        }
+        std::cout << ")" << std::endl;
+    }
+    if (!simulate_mode) {
+        std::cout << "Final sync (fdatasync): " << erase_stats.sync_seconds << " seconds (included in total time)" << std::endl;
+    }
+    std::cout << "Total time: " << passes_duration << " seconds" << std::endl;
     std::cout << "Average speed: " << avg_speed << " MB/s" << std::endl;
+    std::cout << "Peak memory (RSS): " << format_bytes(peak_rss_bytes()) << std::endl;
+    close(fd);
+
+    bool read_back_mismatch = false;
+    for (size_t pass_index = 0; pass_index < read_backs.size(); ++pass_index) {
+        const ReadBackVerifier& read_back = *read_backs[pass_index];
+        if (read_back.failed) {
+            print_error(argv[0], "Read error during read-back verification.", quiet_errors);
+            return finish_telemetry(EXIT_WRITE_FAILED);
+        }
+
+        std::cout << "\nRead-back of erased ranges (pipelined with erase";
+        if (passes.size() > 1) {
+            std::cout << ", pass " << pass_index + 1 << ": " << passes[pass_index].name();
+        }
+        std::cout << ")";
+        print_verification_report(read_back.verified_bytes, read_back.stats);
+        read_back_mismatch = read_back_mismatch || read_back.stats.non_zero_bytes > 0;
+    }
 
-    if (buffer != nullptr) {
-        delete[] buffer;
+    if (read_back_mismatch) {
+        std::cerr << "Error: read-back found bytes that differ from the written pattern." << std::endl;
+        return finish_telemetry(EXIT_WRITE_FAILED);
     }
-    close(fd);
-    return EXIT_OK;
+    return finish_telemetry(EXIT_OK);
 }